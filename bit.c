@@ -5,19 +5,44 @@
  * Bit Utilities
  */
 #include "bit.h"
+#include "bitmap.h"
 
 /**
  * Counts the number of bits that are set
+ *
+ * Uses the POPCNT instruction when the target has it, otherwise counts
+ * the bits in parallel (SWAR) in a fixed number of steps.
+ *
  * @param value - the integer value to count bits in
  * @return number of bits that are set
  */
 unsigned int bit_count(unsigned int value) {
-    unsigned int count = 0, number = value;
-    while(number > 0){
-        number>>=1;
-        count++;
-    }
-    return count;
+#ifdef __POPCNT__
+    return __builtin_popcount(value);
+#else
+    value = value - ((value >> 1) & 0x55555555);
+    value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+    value = (value + (value >> 4)) & 0x0F0F0F0F;
+    return (value * 0x01010101) >> 24;
+#endif
+}
+
+/**
+ * Finds the first (least significant) bit that is set
+ * @param value - the integer value to search
+ * @return bit number of the first set bit (1 to 32), or 0 if no bits are set
+ */
+unsigned int bit_ffs(unsigned int value) {
+    return __builtin_ffs(value);
+}
+
+/**
+ * Finds the last (most significant) bit that is set
+ * @param value - the integer value to search
+ * @return bit number of the last set bit (1 to 32), or 0 if no bits are set
+ */
+unsigned int bit_fls(unsigned int value) {
+    return value ? 32 - __builtin_clz(value) : 0;
 }
 
 /**
@@ -62,3 +87,175 @@ unsigned int bit_toggle(unsigned int value, int bit) {
     value = val;
     return value;
 }
+
+/**
+ * Bitmaps
+ *
+ * A bitmap is an array of unsigned int words holding nbits bits. Unlike the
+ * single-value functions above, bitmap bit positions start at 0; bit n is
+ * bit (n % 32) of word (n / 32). Searches look at a whole word at a time.
+ */
+#define BIT_MAP_WORD_BITS 32
+#define BIT_MAP_WORD(bit) ((bit) / BIT_MAP_WORD_BITS)
+#define BIT_MAP_MASK(bit) (1u << ((bit) % BIT_MAP_WORD_BITS))
+
+/**
+ * Checks if a bit in a bitmap is set
+ * @param map - the bitmap
+ * @param bit - bit position to check
+ * @return 1 if set, 0 if not set
+ */
+unsigned int bit_map_test(unsigned int *map, int bit) {
+    return (map[BIT_MAP_WORD(bit)] & BIT_MAP_MASK(bit)) != 0;
+}
+
+/**
+ * Sets or clears a range of bits in a bitmap
+ *
+ * Whole words inside the range are written at once; only the first and
+ * last word need masking.
+ */
+static void bit_map_fill_range(unsigned int *map, int start, int count, int set) {
+    while (count > 0) {
+        int offset = start % BIT_MAP_WORD_BITS;
+        int n = BIT_MAP_WORD_BITS - offset;
+        unsigned int mask;
+
+        if (n > count) {
+            n = count;
+        }
+        mask = (n == BIT_MAP_WORD_BITS) ? ~0u : ((1u << n) - 1) << offset;
+
+        if (set) {
+            map[BIT_MAP_WORD(start)] |= mask;
+        } else {
+            map[BIT_MAP_WORD(start)] &= ~mask;
+        }
+        start += n;
+        count -= n;
+    }
+}
+
+/**
+ * Sets a range of bits in a bitmap
+ * @param map - the bitmap
+ * @param start - first bit position to set
+ * @param count - number of bits to set
+ */
+void bit_map_set_range(unsigned int *map, int start, int count) {
+    bit_map_fill_range(map, start, count, 1);
+}
+
+/**
+ * Clears a range of bits in a bitmap
+ * @param map - the bitmap
+ * @param start - first bit position to clear
+ * @param count - number of bits to clear
+ */
+void bit_map_clear_range(unsigned int *map, int start, int count) {
+    bit_map_fill_range(map, start, count, 0);
+}
+
+/**
+ * Finds the next bit at or after start that is set (or clear)
+ *
+ * @return bit position found, or nbits if there is none
+ */
+static int bit_map_scan(unsigned int *map, int nbits, int start, int set) {
+    if (start < 0) {
+        start = 0;
+    }
+
+    for (int word = BIT_MAP_WORD(start); word * BIT_MAP_WORD_BITS < nbits; word++) {
+        unsigned int bits = set ? map[word] : ~map[word];
+
+        // Ignore the bits before the starting position in the first word
+        if (word == BIT_MAP_WORD(start)) {
+            bits &= ~(BIT_MAP_MASK(start) - 1);
+        }
+        if (bits) {
+            int bit = word * BIT_MAP_WORD_BITS + bit_ffs(bits) - 1;
+            return (bit < nbits) ? bit : nbits;
+        }
+    }
+    return nbits;
+}
+
+/**
+ * Finds the first bit in a bitmap at or after start that is clear
+ * @param map - the bitmap
+ * @param nbits - number of bits in the bitmap
+ * @param start - bit position to start searching from
+ * @return bit position, or -1 if there is none
+ */
+int bit_map_find_next_zero(unsigned int *map, int nbits, int start) {
+    int bit = bit_map_scan(map, nbits, start, 0);
+    return (bit < nbits) ? bit : -1;
+}
+
+/**
+ * Finds the first bit in a bitmap that is clear
+ * @param map - the bitmap
+ * @param nbits - number of bits in the bitmap
+ * @return bit position, or -1 if all bits are set
+ */
+int bit_map_find_first_zero(unsigned int *map, int nbits) {
+    return bit_map_find_next_zero(map, nbits, 0);
+}
+
+/**
+ * Finds the first bit in a bitmap at or after start that is set
+ * @param map - the bitmap
+ * @param nbits - number of bits in the bitmap
+ * @param start - bit position to start searching from
+ * @return bit position, or -1 if there is none
+ */
+int bit_map_find_next_set(unsigned int *map, int nbits, int start) {
+    int bit = bit_map_scan(map, nbits, start, 1);
+    return (bit < nbits) ? bit : -1;
+}
+
+/**
+ * Finds the first run of count clear bits at or after start
+ *
+ * Alternates between searching for the next clear bit (start of a run)
+ * and the next set bit (end of the run), a word at a time.
+ *
+ * @param map - the bitmap
+ * @param nbits - number of bits in the bitmap
+ * @param start - bit position to start searching from
+ * @param count - number of clear bits needed
+ * @return position of the first bit of the run, or -1 if there is none
+ */
+int bit_map_find_zero_run(unsigned int *map, int nbits, int start, int count) {
+    int bit = bit_map_scan(map, nbits, start, 0);
+
+    while (bit + count <= nbits) {
+        int end = bit_map_scan(map, bit + count, bit, 1);
+
+        if (end - bit >= count) {
+            return bit;
+        }
+        bit = bit_map_scan(map, nbits, end, 0);
+    }
+    return -1;
+}
+
+/**
+ * Counts the number of bits set in a bitmap
+ * @param map - the bitmap
+ * @param nbits - number of bits in the bitmap
+ * @return number of bits that are set
+ */
+int bit_map_count(unsigned int *map, int nbits) {
+    int count = 0;
+    int word;
+
+    for (word = 0; (word + 1) * BIT_MAP_WORD_BITS <= nbits; word++) {
+        count += bit_count(map[word]);
+    }
+    if (word * BIT_MAP_WORD_BITS < nbits) {
+        count += bit_count(map[word] & ((1u << (nbits % BIT_MAP_WORD_BITS)) - 1));
+    }
+    return count;
+}
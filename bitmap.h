@@ -0,0 +1,34 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Bit Scanning and Bitmaps
+ */
+#ifndef BITMAP_H
+#define BITMAP_H
+
+/**
+ * Bit scanning
+ *
+ * Bit numbers are 1-based, as for bit_test() and friends in bit.h, and 0
+ * means no bit is set.
+ */
+unsigned int bit_ffs(unsigned int value);
+unsigned int bit_fls(unsigned int value);
+
+/**
+ * Bitmaps
+ *
+ * A bitmap is an array of unsigned int words holding nbits bits. Bit
+ * positions are 0-based, and searches return -1 when nothing is found.
+ */
+unsigned int bit_map_test(unsigned int *map, int bit);
+void bit_map_set_range(unsigned int *map, int start, int count);
+void bit_map_clear_range(unsigned int *map, int start, int count);
+int bit_map_find_next_zero(unsigned int *map, int nbits, int start);
+int bit_map_find_first_zero(unsigned int *map, int nbits);
+int bit_map_find_next_set(unsigned int *map, int nbits, int start);
+int bit_map_find_zero_run(unsigned int *map, int nbits, int start, int count);
+int bit_map_count(unsigned int *map, int nbits);
+
+#endif
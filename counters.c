@@ -0,0 +1,90 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Instrumentation Counters
+ */
+#include "counters.h"
+#include "fmt.h"
+#include "kernel.h"
+#include "kernel_log.h"
+#include "vga.h"
+#include "vga_ext.h"
+
+// Width of each column of the VGA overlay drawn by counters_dump()
+#define COUNTERS_OVERLAY_WIDTH 40
+
+// Rows the overlay may use: the scroll region, leaving the two lines
+// pinned at the bottom of the screen (and any status field on them) alone
+#define COUNTERS_OVERLAY_ROWS (VGA_HEIGHT - 2)
+
+// Columns needed to fit every counter, and the rows each one then takes
+#define COUNTERS_OVERLAY_COLS ((COUNTER_COUNT + COUNTERS_OVERLAY_ROWS - 1) / COUNTERS_OVERLAY_ROWS)
+#define COUNTERS_OVERLAY_HEIGHT ((COUNTER_COUNT + COUNTERS_OVERLAY_COLS - 1) / COUNTERS_OVERLAY_COLS)
+
+unsigned int counters[COUNTER_COUNT];
+
+#define COUNTER_SUBSYSTEM(id, subsystem, name) [id] = subsystem,
+static const char *counter_subsystems[COUNTER_COUNT] = {
+    COUNTERS(COUNTER_SUBSYSTEM)
+};
+
+#define COUNTER_NAME(id, subsystem, name) [id] = name,
+static const char *counter_names[COUNTER_COUNT] = {
+    COUNTERS(COUNTER_NAME)
+};
+
+/**
+ * Prints a snapshot of all counters to the host and draws it as an
+ * overlay at the top right of the VGA display
+ *
+ * The overlay is laid out in as many columns as it takes to stay above
+ * the pinned lines. Counters that would not fit across the screen are
+ * only printed to the host.
+ */
+void counters_dump(void) {
+    unsigned int snapshot[COUNTER_COUNT];
+    char buf[COUNTERS_OVERLAY_WIDTH + 1];
+    int cols = COUNTERS_OVERLAY_COLS;
+    int left;
+
+    if (cols > VGA_WIDTH / COUNTERS_OVERLAY_WIDTH) {
+        cols = VGA_WIDTH / COUNTERS_OVERLAY_WIDTH;
+    }
+    left = VGA_WIDTH - cols * COUNTERS_OVERLAY_WIDTH;
+
+    // Copy first so the host and VGA output show the same values
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        snapshot[i] = counters[i];
+    }
+
+    kernel_log_flush();
+    kernel_host_printf("counters:\n");
+
+    vga_fill_rect(0, left, COUNTERS_OVERLAY_HEIGHT, cols * COUNTERS_OVERLAY_WIDTH,
+                  VGA_COLOR_BLUE, VGA_COLOR_WHITE, ' ');
+
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        int col = i / COUNTERS_OVERLAY_HEIGHT;
+
+        kernel_host_printf("  %-8s %-18s %10u\n", counter_subsystems[i], counter_names[i], snapshot[i]);
+
+        if (col < cols) {
+            fmt_snprintf(buf, sizeof(buf), " %-8s %-18s %10u", counter_subsystems[i],
+                         counter_names[i], snapshot[i]);
+            vga_puts_at(i % COUNTERS_OVERLAY_HEIGHT, left + col * COUNTERS_OVERLAY_WIDTH,
+                        VGA_COLOR_BLUE, VGA_COLOR_WHITE, buf);
+        }
+    }
+    vga_flush();
+}
+
+/**
+ * Resets all counters to zero
+ */
+void counters_reset(void) {
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        counters[i] = 0;
+    }
+    kernel_log_info("counters reset");
+}
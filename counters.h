@@ -0,0 +1,65 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Instrumentation Counters
+ */
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+/**
+ * Counters and the subsystem they belong to
+ *
+ * Counting is a plain increment of a global array entry. Building with
+ * COUNTERS_DISABLE removes every COUNTER_INC/COUNTER_ADD.
+ */
+#define COUNTERS(X) \
+    X(COUNTER_VGA_PORT_READS,   "vga",      "port reads") \
+    X(COUNTER_VGA_PORT_WRITES,  "vga",      "port writes") \
+    X(COUNTER_VGA_CHARS,        "vga",      "chars written") \
+    X(COUNTER_VGA_SCROLLS,      "vga",      "scrolls") \
+    X(COUNTER_VGA_CURSOR_SYNCS, "vga",      "cursor syncs") \
+    X(COUNTER_VGA_FLUSHES,      "vga",      "flushes") \
+    X(COUNTER_KBD_PORT_READS,   "keyboard", "port reads") \
+    X(COUNTER_KBD_EVENTS,       "keyboard", "scancodes") \
+    X(COUNTER_KBD_DROPS,        "keyboard", "scancodes dropped") \
+    X(COUNTER_PIC_PORT_WRITES,  "pic",      "port writes") \
+    X(COUNTER_IRQS,             "pic",      "interrupts") \
+    X(COUNTER_TIMER_TICKS,      "timer",    "ticks") \
+    X(COUNTER_SCHED_SWITCHES,   "sched",    "context switches") \
+    X(COUNTER_SCHED_IDLE_TICKS, "sched",    "idle ticks") \
+    X(COUNTER_SCHED_BUSY_TICKS, "sched",    "busy ticks") \
+    X(COUNTER_WORKQ_QUEUED,     "workq",    "items queued") \
+    X(COUNTER_WORKQ_DROPS,      "workq",    "items dropped") \
+    X(COUNTER_SERIAL_TX_BYTES,  "serial",   "bytes sent") \
+    X(COUNTER_SERIAL_TX_DROPS,  "serial",   "bytes dropped (tx)") \
+    X(COUNTER_SERIAL_RX_BYTES,  "serial",   "bytes received") \
+    X(COUNTER_SERIAL_RX_DROPS,  "serial",   "bytes dropped (rx)") \
+    X(COUNTER_SERIAL_IRQS,      "serial",   "interrupts") \
+    X(COUNTER_LOG_ERROR,        "log",      "error messages") \
+    X(COUNTER_LOG_WARN,         "log",      "warn messages") \
+    X(COUNTER_LOG_INFO,         "log",      "info messages") \
+    X(COUNTER_LOG_DEBUG,        "log",      "debug messages") \
+    X(COUNTER_LOG_TRACE,        "log",      "trace messages") \
+    X(COUNTER_LOG_DROPS,        "log",      "messages dropped")
+
+#define COUNTER_ID(id, subsystem, name) id,
+typedef enum counter {
+    COUNTERS(COUNTER_ID)
+    COUNTER_COUNT
+} counter_t;
+
+extern unsigned int counters[COUNTER_COUNT];
+
+#ifdef COUNTERS_DISABLE
+#define COUNTER_INC(id) do { } while (0)
+#define COUNTER_ADD(id, n) do { } while (0)
+#else
+#define COUNTER_INC(id) (counters[(id)]++)
+#define COUNTER_ADD(id, n) (counters[(id)] += (n))
+#endif
+
+void counters_dump(void);
+void counters_reset(void);
+
+#endif
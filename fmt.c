@@ -0,0 +1,341 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Streaming Formatter
+ *
+ * A single-pass printf engine that hands its output to a sink callback.
+ * Supported conversions: %d %i %u %x %X %p %c %s %%, with the '-' and '0'
+ * flags, a field width, a precision (for %s and integers), and '*' for
+ * either. The 'l' and 'h' length modifiers are accepted and ignored
+ * (int and long are the same size on this target).
+ */
+#include <spede/stdarg.h>
+
+#include "fmt.h"
+
+// Largest number of digits an unsigned int needs (octal is not supported)
+#define FMT_DIGITS_MAX 10
+
+#define FMT_FLAG_LEFT   0x01    // '-': left-justify within the width
+#define FMT_FLAG_ZERO   0x02    // '0': pad with zeros instead of spaces
+
+static const char fmt_hex_lower[] = "0123456789abcdef";
+static const char fmt_hex_upper[] = "0123456789ABCDEF";
+static const char fmt_spaces[] = "                ";
+static const char fmt_zeros[]  = "0000000000000000";
+
+/**
+ * Sends count copies of a padding character to the sink, in runs of up
+ * to 16 at a time
+ */
+static void fmt_pad(fmt_sink_t sink, void *ctx, const char *pad, int count) {
+    while (count > 0) {
+        int run = (count < 16) ? count : 16;
+        sink(ctx, pad, run);
+        count -= run;
+    }
+}
+
+/**
+ * Converts an unsigned value to digits, filling the buffer from the end
+ *
+ * @return pointer to the first digit
+ */
+static char *fmt_utoa(char *end, unsigned int value, unsigned int base, const char *digits) {
+    char *p = end;
+
+    if (base == 16) {
+        do {
+            *--p = digits[value & 0xF];
+            value >>= 4;
+        } while (value);
+    } else {
+        do {
+            *--p = '0' + value % 10;
+            value /= 10;
+        } while (value);
+    }
+    return p;
+}
+
+/**
+ * Outputs a run of characters padded to the field width
+ *
+ * @param prefix sign or "0x" prefix, placed before any zero padding
+ * @param zeros number of leading zeros required by the precision
+ */
+static int fmt_field(fmt_sink_t sink, void *ctx, const char *prefix, int prefix_len,
+                     int zeros, const char *s, int len, int width, int flags) {
+    int pad = width - (prefix_len + zeros + len);
+
+    if (pad < 0) {
+        pad = 0;
+    }
+
+    if ((flags & FMT_FLAG_ZERO) && !(flags & FMT_FLAG_LEFT)) {
+        zeros += pad;
+        pad = 0;
+    }
+    if (!(flags & FMT_FLAG_LEFT)) {
+        fmt_pad(sink, ctx, fmt_spaces, pad);
+    }
+    if (prefix_len > 0) {
+        sink(ctx, prefix, prefix_len);
+    }
+    fmt_pad(sink, ctx, fmt_zeros, zeros);
+    if (len > 0) {
+        sink(ctx, s, len);
+    }
+    if (flags & FMT_FLAG_LEFT) {
+        fmt_pad(sink, ctx, fmt_spaces, pad);
+    }
+    return prefix_len + zeros + len + pad;
+}
+
+/**
+ * Formats a string, passing the output to a sink
+ *
+ * @param sink - output callback
+ * @param ctx - context pointer passed to the sink
+ * @param fmt - string format
+ * @param args - arguments for the string format
+ * @return number of characters output
+ */
+int fmt_vformat(fmt_sink_t sink, void *ctx, const char *fmt, va_list args) {
+    char digits[FMT_DIGITS_MAX];
+    char *digits_end = digits + sizeof(digits);
+    int count = 0;
+
+    while (*fmt) {
+        // Pass literal text through as one run
+        const char *run = fmt;
+        while (*fmt && *fmt != '%') {
+            fmt++;
+        }
+        if (fmt > run) {
+            sink(ctx, run, fmt - run);
+            count += fmt - run;
+        }
+        if (!*fmt) {
+            break;
+        }
+        fmt++;
+
+        // Flags
+        int flags = 0;
+        for (;; fmt++) {
+            if (*fmt == '-') {
+                flags |= FMT_FLAG_LEFT;
+            } else if (*fmt == '0') {
+                flags |= FMT_FLAG_ZERO;
+            } else {
+                break;
+            }
+        }
+
+        // Width
+        int width = 0;
+        if (*fmt == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                flags |= FMT_FLAG_LEFT;
+                width = -width;
+            }
+            fmt++;
+        } else {
+            while (*fmt >= '0' && *fmt <= '9') {
+                width = width * 10 + (*fmt++ - '0');
+            }
+        }
+
+        // Precision
+        int precision = -1;
+        if (*fmt == '.') {
+            fmt++;
+            precision = 0;
+            if (*fmt == '*') {
+                precision = va_arg(args, int);
+                fmt++;
+            } else {
+                while (*fmt >= '0' && *fmt <= '9') {
+                    precision = precision * 10 + (*fmt++ - '0');
+                }
+            }
+        }
+
+        // Length modifiers make no difference on this target
+        while (*fmt == 'l' || *fmt == 'h') {
+            fmt++;
+        }
+
+        char conv = *fmt++;
+        const char *prefix = "";
+        int prefix_len = 0;
+        unsigned int value;
+        const char *s;
+        int len;
+        char c;
+
+        switch (conv) {
+            case 'd':
+            case 'i': {
+                int n = va_arg(args, int);
+                if (n < 0) {
+                    prefix = "-";
+                    prefix_len = 1;
+                    value = -(unsigned int)n;
+                } else {
+                    value = n;
+                }
+                s = fmt_utoa(digits_end, value, 10, 0);
+                goto integer;
+            }
+
+            case 'u':
+                value = va_arg(args, unsigned int);
+                s = fmt_utoa(digits_end, value, 10, 0);
+                goto integer;
+
+            case 'p':
+                prefix = "0x";
+                prefix_len = 2;
+                value = (unsigned int)(unsigned long)va_arg(args, void *);
+                s = fmt_utoa(digits_end, value, 16, fmt_hex_lower);
+                goto integer;
+
+            case 'x':
+            case 'X':
+                value = va_arg(args, unsigned int);
+                s = fmt_utoa(digits_end, value, 16, (conv == 'x') ? fmt_hex_lower : fmt_hex_upper);
+
+            integer:
+                len = digits_end - s;
+                if (precision >= 0) {
+                    // An explicit precision turns off zero padding
+                    flags &= ~FMT_FLAG_ZERO;
+                    if (precision == 0 && value == 0) {
+                        len = 0;
+                    }
+                }
+                count += fmt_field(sink, ctx, prefix, prefix_len,
+                                   (precision > len) ? precision - len : 0,
+                                   s, len, width, flags);
+                break;
+
+            case 'c':
+                c = (char)va_arg(args, int);
+                count += fmt_field(sink, ctx, "", 0, 0, &c, 1, width, flags & ~FMT_FLAG_ZERO);
+                break;
+
+            case 's':
+                s = va_arg(args, const char *);
+                if (!s) {
+                    s = "(null)";
+                }
+                for (len = 0; s[len] && (precision < 0 || len < precision); len++) {
+                }
+                count += fmt_field(sink, ctx, "", 0, 0, s, len, width, flags & ~FMT_FLAG_ZERO);
+                break;
+
+            case '%':
+                sink(ctx, "%", 1);
+                count++;
+                break;
+
+            case '\0':
+                // Format ended in the middle of a conversion
+                return count;
+
+            default:
+                // Unknown conversion: output it as is
+                sink(ctx, fmt - 2, 2);
+                count += 2;
+                break;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Formats a string, passing the output to a sink
+ *
+ * @param sink - output callback
+ * @param ctx - context pointer passed to the sink
+ * @param fmt - string format
+ * @param ... - arguments for the string format
+ * @return number of characters output
+ */
+int fmt_format(fmt_sink_t sink, void *ctx, const char *fmt, ...) {
+    va_list args;
+    int count;
+
+    va_start(args, fmt);
+    count = fmt_vformat(sink, ctx, fmt, args);
+    va_end(args);
+    return count;
+}
+
+/**
+ * Buffer sink state: output is truncated to fit and always NUL terminated
+ */
+typedef struct fmt_buf {
+    char *buf;
+    int size;
+    int used;
+} fmt_buf_t;
+
+static void fmt_buf_sink(void *ctx, const char *s, int len) {
+    fmt_buf_t *b = ctx;
+    int room = b->size - 1 - b->used;
+
+    if (len > room) {
+        len = room;
+    }
+    if (len <= 0) {
+        return;
+    }
+    for (int i = 0; i < len; i++) {
+        b->buf[b->used + i] = s[i];
+    }
+    b->used += len;
+}
+
+/**
+ * Formats a string into a buffer
+ *
+ * @param buf - buffer to write to
+ * @param size - size of the buffer, including the terminating NUL
+ * @param fmt - string format
+ * @param args - arguments for the string format
+ * @return number of characters the full output needs (excluding the NUL)
+ */
+int fmt_vsnprintf(char *buf, int size, const char *fmt, va_list args) {
+    fmt_buf_t b = { buf, size, 0 };
+    int count = fmt_vformat(fmt_buf_sink, &b, fmt, args);
+
+    if (size > 0) {
+        buf[b.used] = '\0';
+    }
+    return count;
+}
+
+/**
+ * Formats a string into a buffer
+ *
+ * @param buf - buffer to write to
+ * @param size - size of the buffer, including the terminating NUL
+ * @param fmt - string format
+ * @param ... - arguments for the string format
+ * @return number of characters the full output needs (excluding the NUL)
+ */
+int fmt_snprintf(char *buf, int size, const char *fmt, ...) {
+    va_list args;
+    int count;
+
+    va_start(args, fmt);
+    count = fmt_vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return count;
+}
@@ -0,0 +1,29 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Streaming Formatter
+ */
+#ifndef FMT_H
+#define FMT_H
+
+#include <spede/stdarg.h>
+
+/**
+ * Output callback for the formatter
+ *
+ * Receives runs of formatted characters (not NUL terminated) as they are
+ * produced. Literal text between conversions is passed as a single run.
+ *
+ * @param ctx - context pointer given to fmt_vformat
+ * @param buf - characters to output
+ * @param len - number of characters
+ */
+typedef void (*fmt_sink_t)(void *ctx, const char *buf, int len);
+
+int fmt_vformat(fmt_sink_t sink, void *ctx, const char *fmt, va_list args);
+int fmt_format(fmt_sink_t sink, void *ctx, const char *fmt, ...);
+int fmt_vsnprintf(char *buf, int size, const char *fmt, va_list args);
+int fmt_snprintf(char *buf, int size, const char *fmt, ...);
+
+#endif
@@ -0,0 +1,297 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Physical Frame Allocator
+ *
+ * Every physical page frame up to FRAME_MAX has one bit in frame_map:
+ * set if the frame is in use (or not usable memory), clear if free.
+ */
+#include "bit.h"
+#include "bitmap.h"
+#include "frame.h"
+#include "io.h"
+#include "kernel.h"
+#include "kernel_log.h"
+
+/**
+ * CMOS registers holding the installed memory size, as set by the BIOS
+ */
+#define CMOS_PORT_INDEX     0x70
+#define CMOS_PORT_DATA      0x71
+#define CMOS_EXT_MEM_LOW    0x30    // KB above 1 MB (up to 64 MB)
+#define CMOS_EXT_MEM_HIGH   0x31
+#define CMOS_HIGH_MEM_LOW   0x34    // 64 KB blocks above 16 MB
+#define CMOS_HIGH_MEM_HIGH  0x35
+
+// End of the kernel image (provided by the linker)
+extern char end[];
+
+/**
+ * Global variables in this file scope
+ */
+static unsigned int frame_map[FRAME_MAX / 32];
+static int frame_total = 0;     // frames added through frame_region_add
+static int frame_free_count = 0;
+static int frame_hint = 0;      // where the next single-frame search starts
+
+/**
+ * Reads a CMOS register
+ */
+static unsigned int frame_cmos_read(unsigned char reg) {
+    outportb(CMOS_PORT_INDEX, reg);
+    return inportb(CMOS_PORT_DATA);
+}
+
+/**
+ * Returns the end of installed memory as reported by the CMOS, or 0 if
+ * the CMOS reports no extended memory
+ */
+static unsigned int frame_memory_size(void) {
+    unsigned int high = frame_cmos_read(CMOS_HIGH_MEM_LOW) | frame_cmos_read(CMOS_HIGH_MEM_HIGH) << 8;
+    unsigned int ext = frame_cmos_read(CMOS_EXT_MEM_LOW) | frame_cmos_read(CMOS_EXT_MEM_HIGH) << 8;
+
+    if (high) {
+        // Keep the end below 4 GB
+        if (high > 0xF000) {
+            high = 0xF000;
+        }
+        return 0x1000000 + high * 0x10000;
+    }
+    if (ext) {
+        return 0x100000 + ext * 1024;
+    }
+    return 0;
+}
+
+/**
+ * Initializes the allocator with the memory between the end of the
+ * kernel image and the end of installed memory (at most FRAME_MEMORY_END)
+ *
+ * Everything below the end of the kernel image, which includes the
+ * monitor and BIOS areas under 1 MB, is never added. The boot stack may
+ * sit anywhere the monitor put it, so the frames around the current
+ * stack pointer are reserved.
+ */
+void frame_init(void) {
+    unsigned int top = frame_memory_size();
+    unsigned long stack = (unsigned long)&top;
+    unsigned long stack_low = (stack > FRAME_BOOT_STACK_SIZE) ? stack - FRAME_BOOT_STACK_SIZE : 0;
+    unsigned long kernel_end = (unsigned long)end;
+
+    kernel_log_info("Initializing frame allocator");
+
+    if (top == 0) {
+        kernel_log_warn("frame: installed memory unknown, assuming 0x%08x", FRAME_MEMORY_END);
+        top = FRAME_MEMORY_END;
+    } else if (top > FRAME_MEMORY_END) {
+        top = FRAME_MEMORY_END;
+    }
+
+    frame_reset();
+    if (top > kernel_end) {
+        frame_region_add(kernel_end, top - kernel_end);
+    }
+    // A stack above the memory handed out needs nothing reserved
+    if (stack_low < top) {
+        frame_region_reserve(stack_low, stack + FRAME_BOOT_STACK_SIZE - stack_low);
+    }
+
+    kernel_log_info("frame: %d frames free, memory ends at 0x%08x", frame_free_count, top);
+}
+
+/**
+ * Marks every frame as unusable
+ *
+ * Memory must then be added with frame_region_add() before anything can
+ * be allocated.
+ */
+void frame_reset(void) {
+    bit_map_set_range(frame_map, 0, FRAME_MAX);
+    frame_total = 0;
+    frame_free_count = 0;
+    frame_hint = 0;
+}
+
+/**
+ * Adds a region of usable memory to the allocator
+ *
+ * Only whole frames inside the region are added. Frame 0 is never added
+ * so that an address of 0 can indicate a failed allocation.
+ *
+ * @param base - start address of the region
+ * @param size - size of the region in bytes
+ */
+void frame_region_add(unsigned int base, unsigned int size) {
+    unsigned int first = (base + FRAME_SIZE - 1) / FRAME_SIZE;
+    unsigned int last = (base + size) / FRAME_SIZE;    // one past the last frame
+
+    if (first == 0) {
+        first = 1;
+    }
+    if (last > FRAME_MAX) {
+        last = FRAME_MAX;
+    }
+    if (first >= last) {
+        return;
+    }
+
+    bit_map_clear_range(frame_map, first, last - first);
+    frame_total += last - first;
+    frame_free_count += last - first;
+}
+
+/**
+ * Takes a region of memory out of the allocator
+ *
+ * Every frame the region touches (even partly) is marked as in use and no
+ * longer counted. Frames that are already in use are left alone.
+ *
+ * @param base - start address of the region
+ * @param size - size of the region in bytes
+ */
+void frame_region_reserve(unsigned int base, unsigned int size) {
+    unsigned int first = base / FRAME_SIZE;
+    unsigned int last = (base + size + FRAME_SIZE - 1) / FRAME_SIZE;
+
+    // Regions wrapping past 4 GB stop there
+    if (base + size < base) {
+        last = 0x100000;
+    }
+    if (last > FRAME_MAX) {
+        last = FRAME_MAX;
+    }
+
+    for (unsigned int frame = first; frame < last; frame++) {
+        if (!bit_map_test(frame_map, frame)) {
+            bit_map_set_range(frame_map, frame, 1);
+            frame_total--;
+            frame_free_count--;
+        }
+    }
+}
+
+/**
+ * Allocates a single frame
+ *
+ * The search starts where the previous one ended (next fit) and scans the
+ * bitmap a word at a time.
+ *
+ * @return physical address of the frame, or 0 if no frames are free
+ */
+unsigned int frame_alloc(void) {
+    int frame = bit_map_find_next_zero(frame_map, FRAME_MAX, frame_hint);
+
+    if (frame < 0) {
+        frame = bit_map_find_first_zero(frame_map, FRAME_MAX);
+        if (frame < 0) {
+            return 0;
+        }
+    }
+
+    bit_map_set_range(frame_map, frame, 1);
+    frame_free_count--;
+    frame_hint = (frame + 1 < FRAME_MAX) ? frame + 1 : 0;
+
+    return frame * FRAME_SIZE;
+}
+
+/**
+ * Allocates physically contiguous frames
+ *
+ * @param count - number of frames needed
+ * @return physical address of the first frame, or 0 if there is no free
+ *         run that is long enough
+ */
+unsigned int frame_alloc_contig(int count) {
+    if (count <= 0) {
+        return 0;
+    }
+    if (count == 1) {
+        return frame_alloc();
+    }
+
+    int frame = bit_map_find_zero_run(frame_map, FRAME_MAX, 0, count);
+    if (frame < 0) {
+        return 0;
+    }
+
+    bit_map_set_range(frame_map, frame, count);
+    frame_free_count -= count;
+
+    return frame * FRAME_SIZE;
+}
+
+/**
+ * Frees a single frame
+ * @param addr - physical address returned by frame_alloc
+ */
+void frame_free(unsigned int addr) {
+    frame_free_contig(addr, 1);
+}
+
+/**
+ * Frees physically contiguous frames
+ *
+ * @param addr - physical address returned by frame_alloc_contig
+ * @param count - number of frames that were allocated
+ */
+void frame_free_contig(unsigned int addr, int count) {
+    int frame = addr / FRAME_SIZE;
+
+    if (addr % FRAME_SIZE || frame <= 0 || frame + count > FRAME_MAX) {
+        kernel_log_error("frame: invalid free of 0x%08x", addr);
+        return;
+    }
+
+    for (int i = frame; i < frame + count; i++) {
+        if (!bit_map_test(frame_map, i)) {
+            kernel_log_error("frame: double free of 0x%08x", i * FRAME_SIZE);
+            return;
+        }
+    }
+
+    bit_map_clear_range(frame_map, frame, count);
+    frame_free_count += count;
+}
+
+/**
+ * Returns the current allocation statistics
+ *
+ * Finding the largest free run walks the runs of the bitmap, so this is
+ * meant for reporting rather than for the allocation path.
+ *
+ * @param stats - where to store the statistics
+ */
+void frame_stats(frame_stats_t *stats) {
+    int largest = 0;
+    int start = bit_map_find_first_zero(frame_map, FRAME_MAX);
+
+    while (start >= 0) {
+        int end = bit_map_find_next_set(frame_map, FRAME_MAX, start);
+
+        if (end < 0) {
+            end = FRAME_MAX;
+        }
+        if (end - start > largest) {
+            largest = end - start;
+        }
+        start = bit_map_find_next_zero(frame_map, FRAME_MAX, end);
+    }
+
+    stats->total = frame_total;
+    stats->free = frame_free_count;
+    stats->largest_free_run = largest;
+    stats->fragmentation = frame_free_count ? 100 - (largest * 100) / frame_free_count : 0;
+}
+
+/**
+ * Logs the allocation statistics
+ */
+void frame_dump(void) {
+    frame_stats_t stats;
+
+    frame_stats(&stats);
+    kernel_log_info("frame: %d of %d free, largest free run %d, fragmentation %d%%",
+                    stats.free, stats.total, stats.largest_free_run, stats.fragmentation);
+}
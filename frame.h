@@ -0,0 +1,52 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Physical Frame Allocator
+ */
+#ifndef FRAME_H
+#define FRAME_H
+
+// Size of a physical page frame
+#define FRAME_SIZE 4096
+
+// Highest number of frames that can be tracked (32768 frames = 128 MB)
+#ifndef FRAME_MAX
+#define FRAME_MAX 32768
+#endif
+
+// Highest end of the memory handed to the allocator by frame_init(); less
+// is used when the CMOS reports less memory installed
+#ifndef FRAME_MEMORY_END
+#define FRAME_MEMORY_END 0x2000000
+#endif
+
+// Bytes kept free around the boot stack on each side of the stack pointer
+#ifndef FRAME_BOOT_STACK_SIZE
+#define FRAME_BOOT_STACK_SIZE 0x10000
+#endif
+
+/**
+ * Allocation statistics
+ */
+typedef struct frame_stats {
+    int total;              // frames that can be allocated (free or in use)
+    int free;               // frames currently free
+    int largest_free_run;   // longest run of contiguous free frames
+    int fragmentation;      // percent of free frames outside the largest run
+} frame_stats_t;
+
+void frame_init(void);
+void frame_reset(void);
+void frame_region_add(unsigned int base, unsigned int size);
+void frame_region_reserve(unsigned int base, unsigned int size);
+
+unsigned int frame_alloc(void);
+unsigned int frame_alloc_contig(int count);
+void frame_free(unsigned int addr);
+void frame_free_contig(unsigned int addr, int count);
+
+void frame_stats(frame_stats_t *stats);
+void frame_dump(void);
+
+#endif
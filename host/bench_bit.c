@@ -0,0 +1,108 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: bit counting and bitmap searches
+ *
+ * Each is compared with the bit-at-a-time loop it replaces.
+ */
+#include <stdlib.h>
+
+#include "bit.h"
+#include "bitmap.h"
+#include "host.h"
+
+#define VALUES  4096
+#define PASSES  2000
+
+// Frame allocator sized: 32 MB of 4 KB frames
+#define NBITS   8192
+#define WORDS   (NBITS / 32)
+
+static unsigned int values[VALUES];
+static unsigned int map[WORDS];
+static volatile unsigned int sink;
+
+// The original bit_count loop: shifts one bit at a time (and returned the
+// bit length rather than the count)
+__attribute__((noinline, optimize("no-tree-vectorize")))
+static unsigned int loop_count(unsigned int value) {
+    unsigned int count = 0;
+
+    while (value) {
+        count += value & 1;
+        value >>= 1;
+    }
+    return count;
+}
+
+__attribute__((noinline))
+static int loop_find_zero(unsigned int *bits, int nbits, int start) {
+    for (int bit = start; bit < nbits; bit++) {
+        if (!(bits[bit / 32] & (1u << (bit % 32)))) {
+            return bit;
+        }
+    }
+    return -1;
+}
+
+__attribute__((noinline))
+static int loop_zero_run(unsigned int *bits, int nbits, int count) {
+    int run = 0;
+
+    for (int bit = 0; bit < nbits; bit++) {
+        run = (bits[bit / 32] & (1u << (bit % 32))) ? 0 : run + 1;
+        if (run == count) {
+            return bit - count + 1;
+        }
+    }
+    return -1;
+}
+
+int main(void) {
+    unsigned int total;
+    double ns;
+
+    srand(159);
+    for (int i = 0; i < VALUES; i++) {
+        values[i] = (unsigned int)rand() << 16 ^ (unsigned int)rand();
+    }
+
+    ns = HOST_TIME(PASSES, {
+        total = 0;
+        for (int v = 0; v < VALUES; v++) {
+            total += loop_count(values[v]);
+        }
+        sink = total;
+    });
+    host_bench_report("bit count (bit at a time)", ns / VALUES, "ns/word");
+
+    ns = HOST_TIME(PASSES, {
+        total = 0;
+        for (int v = 0; v < VALUES; v++) {
+            total += bit_count(values[v]);
+        }
+        sink = total;
+    });
+    host_bench_report("bit_count", ns / VALUES, "ns/word");
+
+    // A nearly full map: the free bits are at the end
+    bit_map_set_range(map, 0, NBITS);
+    bit_map_clear_range(map, NBITS - 100, 1);
+    bit_map_clear_range(map, NBITS - 40, 8);
+
+    ns = HOST_TIME(PASSES, sink = loop_find_zero(map, NBITS, 0));
+    host_bench_report("find first zero, 8192 bits (bit at a time)", ns, "ns");
+    ns = HOST_TIME(PASSES, sink = bit_map_find_first_zero(map, NBITS));
+    host_bench_report("bit_map_find_first_zero, 8192 bits", ns, "ns");
+
+    ns = HOST_TIME(PASSES, sink = loop_zero_run(map, NBITS, 8));
+    host_bench_report("find run of 8 zeros, 8192 bits (bit at a time)", ns, "ns");
+    ns = HOST_TIME(PASSES, sink = bit_map_find_zero_run(map, NBITS, 0, 8));
+    host_bench_report("bit_map_find_zero_run, 8192 bits", ns, "ns");
+
+    ns = HOST_TIME(PASSES, sink = bit_map_count(map, NBITS));
+    host_bench_report("bit_map_count, 8192 bits", ns, "ns");
+
+    return 0;
+}
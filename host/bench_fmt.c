@@ -0,0 +1,71 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: streaming formatter against the host C library
+ *
+ * SPEDE's vsnprintf is not available on the host, so the host C library
+ * stands in for it.
+ */
+#include <stdarg.h>
+
+#include "fmt.h"
+#include "host.h"
+
+#define MESSAGES 2000000
+
+static char buf[128];
+static unsigned int sink_calls;
+static unsigned int sink_chars;
+
+static void count_sink(void *ctx, const char *s, int len) {
+    sink_calls++;
+    sink_chars += len;
+}
+
+static int host_format(const char *fmt, ...) {
+    va_list args;
+    int n;
+
+    va_start(args, fmt);
+    n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return n;
+}
+
+int main(void) {
+    double ns;
+
+    // A typical log message
+    ns = HOST_TIME(MESSAGES, fmt_snprintf(buf, sizeof(buf),
+                   "keyboard: scancode 0x%02x at %u", (int)(_i & 0xFF), (unsigned int)_i));
+    host_bench_report("fmt_snprintf (log message)", ns, "ns/msg");
+    ns = HOST_TIME(MESSAGES, host_format("keyboard: scancode 0x%02x at %u",
+                   (int)(_i & 0xFF), (unsigned int)_i));
+    host_bench_report("vsnprintf (log message)", ns, "ns/msg");
+
+    // Mostly integers
+    ns = HOST_TIME(MESSAGES, fmt_snprintf(buf, sizeof(buf), "%d %u %x %08X",
+                   (int)_i - 1000000, (unsigned int)_i * 7, (unsigned int)_i, (unsigned int)_i * 13));
+    host_bench_report("fmt_snprintf (4 integers)", ns, "ns/msg");
+    ns = HOST_TIME(MESSAGES, host_format("%d %u %x %08X",
+                   (int)_i - 1000000, (unsigned int)_i * 7, (unsigned int)_i, (unsigned int)_i * 13));
+    host_bench_report("vsnprintf (4 integers)", ns, "ns/msg");
+
+    // Strings with padding, as in the counters and task lists
+    ns = HOST_TIME(MESSAGES, fmt_snprintf(buf, sizeof(buf), "%-10s %-18s %10u",
+                   "keyboard", "scancodes", (unsigned int)_i));
+    host_bench_report("fmt_snprintf (padded strings)", ns, "ns/msg");
+    ns = HOST_TIME(MESSAGES, host_format("%-10s %-18s %10u",
+                   "keyboard", "scancodes", (unsigned int)_i));
+    host_bench_report("vsnprintf (padded strings)", ns, "ns/msg");
+
+    // Straight to a sink, with no buffer: how many runs each message takes
+    ns = HOST_TIME(MESSAGES, fmt_format(count_sink, 0,
+                   "keyboard: scancode 0x%02x at %u", (int)(_i & 0xFF), (unsigned int)_i));
+    host_bench_report("fmt_format to a sink (log message)", ns, "ns/msg");
+    host_bench_report("sink calls per message", (double)sink_calls / MESSAGES, "calls");
+    host_bench_report("characters per sink call", (double)sink_chars / sink_calls, "chars");
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: physical frame allocator under alloc/free churn
+ */
+#include <stdlib.h>
+
+#include "frame.h"
+#include "host.h"
+
+// 32 MB, as frame_init() gives the target
+#define MEMORY      (32 * 1024 * 1024)
+#define FRAMES      (MEMORY / FRAME_SIZE)
+#define OPS         2000000
+
+static unsigned int held[FRAMES];
+static int order[OPS];
+
+int main(void) {
+    frame_stats_t stats;
+    int count = 0;
+    double ns;
+
+    host_memory_init(MEMORY);
+    srand(159);
+    for (int i = 0; i < OPS; i++) {
+        order[i] = rand();
+    }
+
+    // Alloc and free of one frame on an empty allocator
+    ns = HOST_TIME(OPS, frame_free(frame_alloc()));
+    host_bench_report("frame_alloc + frame_free (empty)", ns, "ns/pair");
+
+    // Fill to 3/4 in a random pattern, then churn: each step frees a random
+    // held frame and allocates another
+    for (int i = 0; i < FRAMES; i++) {
+        held[count++] = frame_alloc();
+    }
+    for (int i = 0; i < FRAMES / 4; i++) {
+        int pick = order[i] % count;
+
+        frame_free(held[pick]);
+        held[pick] = held[--count];
+    }
+    ns = HOST_TIME(OPS, {
+        int pick = order[_i] % count;
+
+        frame_free(held[pick]);
+        held[pick] = frame_alloc();
+    });
+    host_bench_report("churn at 75% full (free + alloc)", ns, "ns/pair");
+
+    frame_stats(&stats);
+    host_bench_report("free frames after churn", stats.free, "frames");
+    host_bench_report("largest free run after churn", stats.largest_free_run, "frames");
+    host_bench_report("fragmentation after churn", stats.fragmentation, "%");
+
+    // Contiguous runs in the fragmented map
+    ns = HOST_TIME(1000, {
+        unsigned int addr = frame_alloc_contig(4);
+        if (addr) {
+            frame_free_contig(addr, 4);
+        }
+    });
+    host_bench_report("frame_alloc_contig(4) + free (fragmented)", ns, "ns/pair");
+
+    ns = HOST_TIME(1000, frame_stats(&stats));
+    host_bench_report("frame_stats", ns, "ns");
+
+    // Nearly full: the next-fit search has to pass over used words
+    while (count < FRAMES - 16) {
+        held[count++] = frame_alloc();
+    }
+    ns = HOST_TIME(OPS, {
+        int pick = order[_i] % count;
+
+        frame_free(held[pick]);
+        held[pick] = frame_alloc();
+    });
+    host_bench_report("churn with 16 frames free (free + alloc)", ns, "ns/pair");
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: scancode decoding
+ *
+ * Decodes a recorded stream of scancode set 1 input: text typed with
+ * SHIFT held for capitals and punctuation, CAPS toggled now and then and
+ * keypad keys sent with the extended prefix, each key as make and break.
+ */
+#include <string.h>
+
+#include "keyboard.h"
+#include "host.h"
+
+#define PASSES 200
+
+#define SC_LSHIFT       0x2A
+#define SC_CAPS         0x3A
+#define SC_EXTENDED     0xE0
+#define SC_RELEASE      0x80
+
+static const char text[] =
+    "The quick brown fox jumps over the lazy dog; PACK MY BOX WITH "
+    "five dozen liquor jugs! 0123456789 (x + y) * z = \"value\"\n";
+
+// Scancode and whether SHIFT is needed for each character
+static const char plain[] = "1234567890-=\tqwertyuiop[]\nasdfghjkl;'`\\zxcvbnm,./ ";
+static const char shifted[] = "!@#$%^&*()_+\tQWERTYUIOP{}\nASDFGHJKL:\"~|ZXCVBNM<>? ";
+static const unsigned char codes[] = {
+    0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C,
+    0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2B,
+    0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x39,
+};
+
+static unsigned char stream[64 * 1024];
+static int stream_len = 0;
+
+static void record(unsigned char code) {
+    stream[stream_len++] = code;
+}
+
+static void record_key(unsigned char code) {
+    record(code);
+    record(code | SC_RELEASE);
+}
+
+int main(void) {
+    unsigned long long start;
+    unsigned int keys = 0;
+    double ns;
+
+    // Record the stream
+    while (stream_len < (int)sizeof(stream) - 256) {
+        for (const char *c = text; *c; c++) {
+            const char *p = strchr(plain, *c);
+            bool shift = false;
+
+            if (!p) {
+                p = strchr(shifted, *c);
+                shift = true;
+            }
+            if (shift) {
+                record(SC_LSHIFT);
+            }
+            record_key(codes[p - (shift ? shifted : plain)]);
+            if (shift) {
+                record(SC_LSHIFT | SC_RELEASE);
+            }
+        }
+        record_key(SC_CAPS);
+        record(SC_EXTENDED);
+        record(0x1C);
+        record(SC_EXTENDED);
+        record(0x1C | SC_RELEASE);
+    }
+
+    start = host_ns();
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (int i = 0; i < stream_len; i++) {
+            keys += keyboard_decode(stream[i]) != KEY_NULL;
+        }
+    }
+    ns = (double)(host_ns() - start);
+
+    host_bench_report("keyboard_decode", ns / ((double)PASSES * stream_len), "ns/scancode");
+    host_bench_report("keyboard_decode throughput",
+                      (double)PASSES * stream_len / (ns / 1e3), "Mscancodes/s");
+    host_bench_report("keys decoded per scancode", (double)keys / ((double)PASSES * stream_len), "");
+
+    return 0;
+}
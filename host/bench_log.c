@@ -0,0 +1,61 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: kernel log throughput
+ *
+ * Messages are written to the log ring and drained to the host console
+ * (discarded here), as the log task does on the target.
+ */
+#include "kernel.h"
+#include "kernel_log.h"
+#include "host.h"
+
+#define MESSAGES 1000000
+
+// Messages written before each drain; the ring holds 64 by default
+#define BURST 32
+
+int main(void) {
+    unsigned long long start;
+    double ns;
+
+    host_quiet(true);
+
+    // Writers only: format into the ring, drain without timing
+    ns = 0;
+    for (int i = 0; i < MESSAGES; i += BURST) {
+        start = host_ns();
+        for (int j = 0; j < BURST; j++) {
+            kernel_log_info("keyboard: scancode 0x%02x at %u", j, i);
+        }
+        ns += host_ns() - start;
+        kernel_log_flush();
+    }
+    host_quiet(false);
+    host_bench_report("kernel_log_info (write to ring)", ns / MESSAGES, "ns/msg");
+
+    // Writers and drain together
+    host_quiet(true);
+    start = host_ns();
+    for (int i = 0; i < MESSAGES; i += BURST) {
+        for (int j = 0; j < BURST; j++) {
+            kernel_log_info("keyboard: scancode 0x%02x at %u", j, i);
+        }
+        kernel_log_flush();
+    }
+    ns = (double)(host_ns() - start);
+    host_quiet(false);
+    host_bench_report("kernel_log_info + drain", ns / MESSAGES, "ns/msg");
+    host_bench_report("log throughput", MESSAGES / (ns / 1e9), "msg/s");
+
+    // Messages below the run-time level cost only the level check
+    host_quiet(true);
+    kernel_set_log_level(KERNEL_LOG_LEVEL_WARN);
+    ns = HOST_TIME(MESSAGES, kernel_log_debug("filtered %d", (int)_i));
+    kernel_log_flush();
+    host_quiet(false);
+    host_bench_report("kernel_log_debug (filtered at run time)", ns, "ns/msg");
+
+    return 0;
+}
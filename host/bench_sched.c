@@ -0,0 +1,75 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: context switch latency
+ *
+ * Times the scheduler's part of a switch: picking the next task and
+ * handing back its saved trapframe, as on the way out of an interrupt.
+ * The entry stub's register save and restore (a pusha/popa and a stack
+ * switch) is not included. The spawned tasks never actually run.
+ */
+#include "counters.h"
+#include "interrupts.h"
+#include "sched.h"
+#include "timer.h"
+#include "host.h"
+
+#define SWITCHES    5000000
+#define TICKS       5000000
+
+static void task(void *arg) {
+}
+
+int main(void) {
+    static const int counts[] = { 1, 4, 16, 64 };
+    trapframe_t boot_frame = { 0 };
+    trapframe_t *frame = &boot_frame;
+    int spawned = 0;
+    unsigned int switches;
+    double ns;
+
+    host_memory_init(1024 * 1024);
+    host_quiet(true);
+    sched_init();
+    timer_init(TIMER_HZ);
+    host_quiet(false);
+
+    // A forced switch at every interrupt exit (as for sched_yield), with
+    // more and more tasks ready: the cost should not grow
+    for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        char name[48];
+
+        host_quiet(true);
+        while (spawned < counts[c]) {
+            sched_spawn("bench", task, 0);
+            spawned++;
+        }
+        host_quiet(false);
+
+        switches = counters[COUNTER_SCHED_SWITCHES];
+        ns = HOST_TIME(SWITCHES, {
+            sched_preempt();
+            frame = sched_irq_exit(frame);
+        });
+        HOST_CHECK_EQ(counters[COUNTER_SCHED_SWITCHES] - switches, SWITCHES);
+
+        snprintf(name, sizeof(name), "switch, %d tasks ready", counts[c] + 1);
+        host_bench_report(name, ns, "ns/switch");
+    }
+
+    // Timer interrupts: handler, EOI and exit, switching every quantum
+    switches = counters[COUNTER_SCHED_SWITCHES];
+    ns = HOST_TIME(TICKS, {
+        host_irq(IRQ_TIMER);
+        frame = sched_irq_exit(frame);
+    });
+    host_bench_report("timer tick (switch every quantum)", ns, "ns/tick");
+    host_bench_report("switches per tick", (double)(counters[COUNTER_SCHED_SWITCHES] - switches) / TICKS, "");
+
+    // An interrupt exit that does not switch
+    ns = HOST_TIME(SWITCHES, frame = sched_irq_exit(frame));
+    host_bench_report("interrupt exit without a switch", ns, "ns");
+
+    return host_failures != 0;
+}
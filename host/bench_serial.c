@@ -0,0 +1,75 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: interrupt-driven serial output against polling
+ *
+ * The UART model sends a FIFO's worth at a time, so these count the
+ * driver's work per byte, not the line's: port accesses, interrupts and
+ * the CPU time spent in the driver.
+ */
+#include <string.h>
+
+#include "interrupts.h"
+#include "io.h"
+#include "keyboard.h"
+#include "serial.h"
+#include "host.h"
+
+#define MESSAGE     80
+#define MESSAGES    20000
+
+#define COM1_LSR    (SERIAL_COM1 + 5)
+
+static char msg[MESSAGE];
+static int irqs;
+
+// Lets the line send everything, taking each interrupt the UART raises
+static void drain(void) {
+    while (host_uart_send(16) > 0 || host_uart_irq_pending()) {
+        if (host_uart_irq_pending()) {
+            host_irq(IRQ_COM1);
+            irqs++;
+        }
+    }
+    host_uart_output_reset();
+}
+
+// The driver this replaces: wait for an empty transmitter, write one byte
+static void polled_write(const char *buf, int len) {
+    for (int i = 0; i < len; i++) {
+        while (!(inportb(COM1_LSR) & 0x20)) {
+        }
+        outportb(SERIAL_COM1, buf[i]);
+        host_uart_send(16);
+    }
+    host_uart_output_reset();
+}
+
+int main(void) {
+    double ns;
+    double bytes = (double)MESSAGE * MESSAGES;
+
+    memset(msg, 'x', sizeof(msg));
+    host_uart_attach();
+    host_quiet(true);
+    keyboard_init();
+    serial_init();
+    host_quiet(false);
+
+    host_port_reset();
+    ns = HOST_TIME(MESSAGES, {
+        serial_write(msg, MESSAGE);
+        drain();
+    });
+    host_bench_report("serial_write + THRE interrupts", ns / MESSAGE, "ns/byte");
+    host_bench_report("port accesses", host_port_total() / bytes, "per byte");
+    host_bench_report("interrupts", irqs / bytes, "per byte");
+
+    host_port_reset();
+    ns = HOST_TIME(MESSAGES, polled_write(msg, MESSAGE));
+    host_bench_report("polled, one byte at a time", ns / MESSAGE, "ns/byte");
+    host_bench_report("port accesses", host_port_total() / bytes, "per byte");
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: slab caches and arenas against the host C library malloc
+ */
+#include <stdlib.h>
+
+#include "slab.h"
+#include "host.h"
+
+#define MEMORY      (32 * 1024 * 1024)
+#define OPS         5000000
+#define BATCH       10000
+#define ROUNDS      200
+
+static void *objs[BATCH];
+
+int main(void) {
+    slab_cache_t cache;
+    double ns;
+
+    host_memory_init(MEMORY);
+    host_quiet(true);
+    slab_init();
+    slab_cache_init(&cache, "bench", 48);
+    host_quiet(false);
+
+    // One object at a time
+    ns = HOST_TIME(OPS, slab_free(slab_alloc(&cache)));
+    host_bench_report("slab_alloc + slab_free (48 bytes)", ns, "ns/pair");
+    ns = HOST_TIME(OPS, slab_free(slab_kalloc(48)));
+    host_bench_report("slab_kalloc + slab_free (48 bytes)", ns, "ns/pair");
+    ns = HOST_TIME(OPS, {
+        void *volatile p = malloc(48);
+        free(p);
+    });
+    host_bench_report("malloc + free (48 bytes)", ns, "ns/pair");
+
+    // Batches: allocate many, then free them in reverse
+    ns = HOST_TIME(ROUNDS, {
+        for (int i = 0; i < BATCH; i++) {
+            objs[i] = slab_alloc(&cache);
+        }
+        for (int i = BATCH - 1; i >= 0; i--) {
+            slab_free(objs[i]);
+        }
+    });
+    host_bench_report("slab batch of 10000 (48 bytes)", ns / BATCH, "ns/object");
+    ns = HOST_TIME(ROUNDS, {
+        for (int i = 0; i < BATCH; i++) {
+            objs[i] = malloc(48);
+        }
+        for (int i = BATCH - 1; i >= 0; i--) {
+            free(objs[i]);
+        }
+    });
+    host_bench_report("malloc batch of 10000 (48 bytes)", ns / BATCH, "ns/object");
+
+    // Scratch allocations released together
+    {
+        static char mem[64 * 1024];
+        arena_t arena;
+
+        arena_init(&arena, mem, sizeof(mem));
+        ns = HOST_TIME(ROUNDS * 10, {
+            for (int i = 0; i < 512; i++) {
+                objs[i] = arena_alloc(&arena, 100);
+            }
+            arena_reset(&arena);
+        });
+        host_bench_report("arena_alloc (100 bytes, reset per 512)", ns / 512, "ns/object");
+        ns = HOST_TIME(ROUNDS * 10, {
+            for (int i = 0; i < 512; i++) {
+                objs[i] = malloc(100);
+            }
+            for (int i = 0; i < 512; i++) {
+                free(objs[i]);
+            }
+        });
+        host_bench_report("malloc + free (100 bytes, 512 at a time)", ns / 512, "ns/object");
+    }
+
+    host_bench_report("slab frames used", cache.frames, "frames");
+    host_bench_report("slab high-water mark", cache.high_water, "objects");
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: VGA driver time and port I/O per call
+ *
+ * Times are for the host CPU writing to ordinary memory, so they compare
+ * versions of the driver code rather than predict the target. Port I/O
+ * counts are exact: each one is an outportb/inportb the target would run.
+ */
+#include <string.h>
+
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+#define ITERATIONS 200000
+
+/**
+ * Reports the port I/O operations done by one call
+ */
+#define PORT_IO(name, stmt)                                                     \
+    do {                                                                        \
+        host_port_reset();                                                      \
+        stmt;                                                                   \
+        host_bench_report("port I/O per " name, host_port_total(), "ops");      \
+    } while (0)
+
+int main(void) {
+    char line[VGA_WIDTH];
+    double ns;
+
+    // A full line of text (79 characters and a new-line), so every call scrolls
+    memset(line, 'x', sizeof(line) - 2);
+    line[VGA_WIDTH - 2] = '\n';
+    line[VGA_WIDTH - 1] = '\0';
+
+    vga_init();
+    vga_cursor_enable();
+
+    ns = HOST_TIME(ITERATIONS * 10, vga_putc('a' + (_i % 26)));
+    host_bench_report("vga_putc", ns, "ns/char");
+
+    ns = HOST_TIME(ITERATIONS, vga_puts(line));
+    host_bench_report("vga_puts (80-char lines)", ns / VGA_WIDTH, "ns/char");
+
+    ns = HOST_TIME(ITERATIONS, vga_printf("%s %d %x\n", "value", (int)_i, (unsigned int)_i));
+    host_bench_report("vga_printf (\"%s %d %x\\n\")", ns, "ns/call");
+
+    ns = HOST_TIME(ITERATIONS, vga_scroll());
+    host_bench_report("vga_scroll", ns, "ns/call");
+
+    vga_ring_enable();
+    ns = HOST_TIME(ITERATIONS, vga_scroll());
+    host_bench_report("vga_scroll (ring)", ns, "ns/call");
+    PORT_IO("vga_scroll (ring)", vga_scroll());
+    vga_ring_disable();
+
+    ns = HOST_TIME(ITERATIONS / 10, vga_clear());
+    host_bench_report("vga_clear", ns, "ns/call");
+
+    ns = HOST_TIME(ITERATIONS / 10, vga_clear_bg(_i & 0xF));
+    host_bench_report("vga_clear_bg", ns, "ns/call");
+
+    ns = HOST_TIME(ITERATIONS / 10, vga_clear_fg(_i & 0xF));
+    host_bench_report("vga_clear_fg", ns, "ns/call");
+
+    vga_set_rowcol(0, 0);
+    PORT_IO("vga_putc", vga_putc('a'));
+    PORT_IO("vga_puts (80-char line)", vga_puts(line));
+    PORT_IO("vga_printf (\"%d\\n\")", vga_printf("%d\n", 12345));
+    PORT_IO("vga_set_rowcol", vga_set_rowcol(5, 5));
+    PORT_IO("vga_set_rowcol (same position)", vga_set_rowcol(5, 5));
+    PORT_IO("vga_scroll", vga_scroll());
+    PORT_IO("vga_clear", vga_clear());
+    PORT_IO("vga_putc_at", vga_putc_at(1, 1, VGA_COLOR_BLACK, VGA_COLOR_WHITE, 'a'));
+    PORT_IO("vga_cursor_disable", vga_cursor_disable());
+    PORT_IO("vga_cursor_enable", vga_cursor_enable());
+
+    // Cursor updates deferred to the end of each vga_puts/vga_printf
+    vga_cursor_defer(true);
+    ns = HOST_TIME(ITERATIONS * 10, vga_putc('a' + (_i % 26)));
+    host_bench_report("vga_putc (deferred cursor)", ns, "ns/char");
+    ns = HOST_TIME(ITERATIONS, vga_puts(line));
+    host_bench_report("vga_puts (80-char lines, deferred cursor)", ns / VGA_WIDTH, "ns/char");
+    vga_set_rowcol(0, 0);
+    PORT_IO("vga_putc (deferred cursor)", vga_putc('a'));
+    PORT_IO("vga_puts (40 chars, deferred cursor)", vga_puts(line + VGA_WIDTH / 2));
+    PORT_IO("vga_printf (\"%s %d\", deferred cursor)", vga_printf("%s %d", "value", 12345));
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host benchmarks: video memory accesses saved by the VGA shadow buffer
+ *
+ * A burst of log lines scrolls the screen many times. It is printed
+ * straight to video memory, through the shadow with a flush after every
+ * vga_printf (autoflush), and through the shadow with one flush at the end.
+ * The ring modes scroll by moving the CRTC start address instead.
+ */
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+#define LINES 200
+
+typedef enum {
+    MODE_DIRECT,
+    MODE_AUTOFLUSH,
+    MODE_BATCHED,
+    MODE_RING,
+    MODE_RING_BATCHED
+} mode_t;
+
+static const char *mode_names[] = {
+    [MODE_DIRECT]    = "direct",
+    [MODE_AUTOFLUSH] = "shadow, autoflush",
+    [MODE_BATCHED]   = "shadow, one flush per burst",
+    [MODE_RING]      = "ring",
+    [MODE_RING_BATCHED] = "ring, shadow, one flush",
+};
+
+static void burst(void) {
+    for (int i = 0; i < LINES; i++) {
+        vga_printf("info: keyboard: scancode 0x%02x decoded to '%c' (%d)\n", i & 0x7F, 'a' + i % 26, i);
+    }
+    vga_flush();
+}
+
+static void setup(mode_t mode) {
+    vga_shadow_disable();
+    vga_ring_disable();
+    vga_init();
+    if (mode == MODE_RING || mode == MODE_RING_BATCHED) {
+        vga_ring_enable();
+    }
+    if (mode == MODE_AUTOFLUSH) {
+        vga_shadow_enable(true);
+    } else if (mode == MODE_BATCHED || mode == MODE_RING_BATCHED) {
+        vga_shadow_enable(false);
+    }
+}
+
+int main(void) {
+    char name[96];
+
+    for (mode_t mode = MODE_DIRECT; mode <= MODE_RING_BATCHED; mode++) {
+        setup(mode);
+        host_vga_watch(true);
+        burst();
+        host_vga_watch(false);
+
+        snprintf(name, sizeof(name), "%d-line burst, %s: video memory writes", LINES, mode_names[mode]);
+        host_bench_report(name, host_vga_writes(), "accesses");
+        snprintf(name, sizeof(name), "%d-line burst, %s: video memory reads", LINES, mode_names[mode]);
+        host_bench_report(name, host_vga_reads(), "accesses");
+
+        setup(mode);
+        double ns = HOST_TIME(100, burst());
+        snprintf(name, sizeof(name), "%d-line burst, %s", LINES, mode_names[mode]);
+        host_bench_report(name, ns / 1000, "us");
+    }
+
+    return 0;
+}
@@ -0,0 +1,680 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host Test and Benchmark Harness
+ */
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "counters.h"
+#include "frame.h"
+#include "interrupts.h"
+#include "io.h"
+#include "kernel.h"
+#include "kernel_log.h"
+#include "trace.h"
+#include "vga.h"
+#include "host.h"
+
+// Host address of the memory handed to the frame allocator: frame
+// addresses are 32-bit and the allocator tracks the first FRAME_MAX frames
+#define HOST_MEMORY_BASE 0x06000000
+
+// Scancodes the keyboard controller model can hold
+#define HOST_KBD_QUEUE 4096
+
+// UART model: I/O base (COM1), FIFO depth and bytes kept of what it sent
+#define HOST_UART_BASE      0x3F8
+#define HOST_UART_FIFO      16
+#define HOST_UART_OUTPUT    65536
+
+/**
+ * Global variables in this file scope
+ */
+unsigned short host_vga_memory[0x4000] __attribute__((aligned(4096)));
+int host_failures = 0;
+
+static unsigned long port_reads[0x10000];
+static unsigned long port_writes[0x10000];
+static unsigned long port_total = 0;
+
+static host_port_read_t port_read_fn[0x10000];
+static host_port_write_t port_write_fn[0x10000];
+static unsigned char port_latch[0x10000];      // last value written, for ports with no model
+
+static unsigned char crtc_index = 0;
+static unsigned char crtc_regs[256];
+
+static unsigned char kbd_queue[HOST_KBD_QUEUE];
+static int kbd_head = 0;
+static int kbd_tail = 0;
+
+static struct {
+    unsigned char ier, lcr, mcr, scr, dll, dlm;
+    unsigned char tx_fifo[HOST_UART_FIFO];
+    int tx_count;
+    unsigned char rx_fifo[HOST_UART_FIFO];
+    int rx_head;
+    int rx_count;
+    bool rx_overrun;            // a byte was lost since LSR was last read
+    bool thre_pending;          // THRE interrupt raised and not yet identified
+    int fifo_overruns;          // THR writes while the transmit FIFO was full
+    char output[HOST_UART_OUTPUT];
+    int output_len;
+} uart;
+
+static bool irq_enabled = false;
+static irq_handler_t irq_handlers[IRQ_COUNT];
+static int breakpoints = 0;
+
+static unsigned int memory_base = 0;
+static unsigned int memory_size = 0;
+
+static int quiet_stdout = -1;               // saved stdout while output is discarded
+
+static volatile bool vga_watching = false;
+static volatile unsigned long vga_reads = 0;
+static volatile unsigned long vga_writes = 0;
+
+/**
+ * Port I/O
+ */
+
+/**
+ * Registers a device model for a range of ports
+ *
+ * @param first - first port of the range
+ * @param last - last port of the range
+ * @param read - called for inportb on the range, or 0 to read back the last value written
+ * @param write - called for outportb on the range, or 0 to only latch the value
+ */
+void host_port_device(unsigned short first, unsigned short last,
+                      host_port_read_t read, host_port_write_t write) {
+    for (unsigned int port = first; port <= last; port++) {
+        port_read_fn[port] = read;
+        port_write_fn[port] = write;
+    }
+}
+
+/**
+ * Clears the per-port access counts (device models keep their state)
+ */
+void host_port_reset(void) {
+    memset(port_reads, 0, sizeof(port_reads));
+    memset(port_writes, 0, sizeof(port_writes));
+    port_total = 0;
+}
+
+unsigned long host_port_reads(unsigned short port) {
+    return port_reads[port];
+}
+
+unsigned long host_port_writes(unsigned short port) {
+    return port_writes[port];
+}
+
+/**
+ * Returns the number of port reads and writes since the last reset
+ */
+unsigned long host_port_total(void) {
+    return port_total;
+}
+
+unsigned char inportb(unsigned short port) {
+    port_reads[port]++;
+    port_total++;
+    return port_read_fn[port] ? port_read_fn[port](port) : port_latch[port];
+}
+
+void outportb(unsigned short port, unsigned char value) {
+    port_writes[port]++;
+    port_total++;
+    port_latch[port] = value;
+    if (port_write_fn[port]) {
+        port_write_fn[port](port, value);
+    }
+}
+
+/**
+ * CRTC model: an index register at 0x3D4 selecting a data register at 0x3D5
+ */
+static unsigned char crtc_read(unsigned short port) {
+    return (port == VGA_PORT_DATA) ? crtc_regs[crtc_index] : crtc_index;
+}
+
+static void crtc_write(unsigned short port, unsigned char value) {
+    if (port == VGA_PORT_ADDR) {
+        crtc_index = value;
+    } else {
+        crtc_regs[crtc_index] = value;
+    }
+}
+
+/**
+ * Returns the value last written to a CRTC register
+ * @param index - register index (such as 0x0E for the cursor location high byte)
+ */
+unsigned char host_crtc_register(int index) {
+    return crtc_regs[index & 0xFF];
+}
+
+/**
+ * Keyboard controller model: 0x64 reports whether a scancode is waiting and
+ * 0x60 returns it
+ */
+static unsigned char kbd_read(unsigned short port) {
+    if (port == 0x64) {
+        return (kbd_head != kbd_tail) ? 0x01 : 0x00;
+    }
+    if (kbd_head == kbd_tail) {
+        return 0;
+    }
+    unsigned char c = kbd_queue[kbd_tail];
+    kbd_tail = (kbd_tail + 1) % HOST_KBD_QUEUE;
+    return c;
+}
+
+/**
+ * Queues scancodes in the keyboard controller model
+ *
+ * Codes that do not fit are discarded, like a controller that is not read.
+ *
+ * @param codes - scancodes to queue
+ * @param count - number of scancodes
+ */
+void host_kbd_feed(const unsigned char *codes, int count) {
+    for (int i = 0; i < count; i++) {
+        int next = (kbd_head + 1) % HOST_KBD_QUEUE;
+        if (next == kbd_tail) {
+            break;
+        }
+        kbd_queue[kbd_head] = codes[i];
+        kbd_head = next;
+    }
+}
+
+/**
+ * Returns the number of scancodes waiting in the keyboard controller model
+ */
+int host_kbd_pending(void) {
+    return (kbd_head - kbd_tail + HOST_KBD_QUEUE) % HOST_KBD_QUEUE;
+}
+
+/**
+ * 16550 UART model
+ *
+ * Bytes written to THR wait in a 16 byte transmit FIFO until the test
+ * "sends" them with host_uart_send(); the FIFO becoming empty raises the
+ * THRE interrupt if it is enabled. Received bytes wait in a 16 byte
+ * receive FIFO; more than that are lost and flagged as an overrun.
+ */
+static void uart_thre_check(void) {
+    if (uart.tx_count == 0 && (uart.ier & 0x02)) {
+        uart.thre_pending = true;
+    }
+}
+
+static unsigned char uart_read(unsigned short port) {
+    unsigned char value;
+
+    switch (port - HOST_UART_BASE) {
+        case 0:
+            if (uart.lcr & 0x80) {
+                return uart.dll;
+            }
+            if (uart.rx_count == 0) {
+                return 0;
+            }
+            value = uart.rx_fifo[uart.rx_head];
+            uart.rx_head = (uart.rx_head + 1) % HOST_UART_FIFO;
+            uart.rx_count--;
+            return value;
+
+        case 1:
+            return (uart.lcr & 0x80) ? uart.dlm : uart.ier;
+
+        case 2:
+            // Highest priority interrupt first; identifying THRE clears it
+            if ((uart.ier & 0x04) && uart.rx_overrun) {
+                return 0x06;
+            }
+            if ((uart.ier & 0x01) && uart.rx_count > 0) {
+                return 0x04;
+            }
+            if ((uart.ier & 0x02) && uart.thre_pending) {
+                uart.thre_pending = false;
+                return 0x02;
+            }
+            return 0x01;
+
+        case 3:
+            return uart.lcr;
+
+        case 4:
+            return uart.mcr;
+
+        case 5:
+            value = (uart.rx_count > 0 ? 0x01 : 0) | (uart.rx_overrun ? 0x02 : 0) |
+                    (uart.tx_count == 0 ? 0x60 : 0);
+            uart.rx_overrun = false;
+            return value;
+
+        case 7:
+            return uart.scr;
+
+        default:
+            return 0;
+    }
+}
+
+static void uart_write(unsigned short port, unsigned char value) {
+    switch (port - HOST_UART_BASE) {
+        case 0:
+            if (uart.lcr & 0x80) {
+                uart.dll = value;
+            } else if (uart.tx_count == HOST_UART_FIFO) {
+                uart.fifo_overruns++;
+            } else {
+                uart.tx_fifo[uart.tx_count++] = value;
+                uart.thre_pending = false;
+            }
+            break;
+
+        case 1:
+            if (uart.lcr & 0x80) {
+                uart.dlm = value;
+            } else {
+                // Enabling THRE with the FIFO empty raises it right away
+                bool thre_enabled = (value & 0x02) && !(uart.ier & 0x02);
+
+                uart.ier = value;
+                if (thre_enabled) {
+                    uart_thre_check();
+                }
+            }
+            break;
+
+        case 2:
+            // FIFO control: clear the FIFOs if asked
+            if (value & 0x02) {
+                uart.rx_count = 0;
+            }
+            if (value & 0x04) {
+                uart.tx_count = 0;
+            }
+            break;
+
+        case 3:
+            uart.lcr = value;
+            break;
+
+        case 4:
+            uart.mcr = value;
+            break;
+
+        case 7:
+            uart.scr = value;
+            break;
+    }
+}
+
+/**
+ * Puts the UART model at COM1 with empty FIFOs and no output
+ */
+void host_uart_attach(void) {
+    memset(&uart, 0, sizeof(uart));
+    host_port_device(HOST_UART_BASE, HOST_UART_BASE + 7, uart_read, uart_write);
+}
+
+/**
+ * Sends bytes from the transmit FIFO down the line
+ *
+ * @param max - most bytes to send
+ * @return number of bytes sent
+ */
+int host_uart_send(int max) {
+    int count = (max < uart.tx_count) ? max : uart.tx_count;
+
+    for (int i = 0; i < count; i++) {
+        if (uart.output_len < HOST_UART_OUTPUT) {
+            uart.output[uart.output_len++] = uart.tx_fifo[i];
+        }
+    }
+    memmove(uart.tx_fifo, uart.tx_fifo + count, uart.tx_count - count);
+    uart.tx_count -= count;
+    if (count > 0) {
+        uart_thre_check();
+    }
+    return count;
+}
+
+/**
+ * Receives bytes from the line into the receive FIFO
+ *
+ * @param buf - bytes received
+ * @param len - number of bytes
+ */
+void host_uart_receive(const char *buf, int len) {
+    for (int i = 0; i < len; i++) {
+        if (uart.rx_count == HOST_UART_FIFO) {
+            uart.rx_overrun = true;
+            continue;
+        }
+        uart.rx_fifo[(uart.rx_head + uart.rx_count) % HOST_UART_FIFO] = buf[i];
+        uart.rx_count++;
+    }
+}
+
+/**
+ * Returns whether the UART model has an enabled interrupt pending
+ */
+bool host_uart_irq_pending(void) {
+    return ((uart.ier & 0x04) && uart.rx_overrun) ||
+           ((uart.ier & 0x01) && uart.rx_count > 0) ||
+           ((uart.ier & 0x02) && uart.thre_pending);
+}
+
+/**
+ * Returns the bytes sent so far (not NUL terminated) and their count
+ */
+const char *host_uart_output(int *len) {
+    *len = uart.output_len;
+    return uart.output;
+}
+
+void host_uart_output_reset(void) {
+    uart.output_len = 0;
+}
+
+/**
+ * Returns the number of bytes written to THR while the transmit FIFO was
+ * full (lost on real hardware)
+ */
+int host_uart_fifo_overruns(void) {
+    return uart.fifo_overruns;
+}
+
+/**
+ * Returns a UART register as last programmed: 0 and 1 are the divisor
+ * latch, 2 is IER, 3 is LCR and 4 is MCR
+ */
+unsigned char host_uart_register(int reg) {
+    switch (reg) {
+        case 0:  return uart.dll;
+        case 1:  return uart.dlm;
+        case 2:  return uart.ier;
+        case 3:  return uart.lcr;
+        case 4:  return uart.mcr;
+        default: return 0;
+    }
+}
+
+/**
+ * Video memory access counting
+ *
+ * The video memory pages are mapped with no access. An access faults: the
+ * fault handler counts it as a read or write from the page fault error
+ * code, opens the pages for that kind of access and sets the trap flag, so
+ * the instruction runs once and then traps; the trap handler closes the
+ * pages again. An instruction that reads and then writes video memory
+ * faults twice and counts as both.
+ */
+#define X86_PF_WRITE    0x02    // page fault error code: the access was a write
+#define X86_EFLAGS_TF   0x100   // trap flag: single-step
+
+static void vga_fault(int sig, siginfo_t *info, void *context) {
+    ucontext_t *uc = context;
+    char *addr = info->si_addr;
+    char *base = (char *)host_vga_memory;
+
+    if (!vga_watching || addr < base || addr >= base + sizeof(host_vga_memory)) {
+        // A real fault: let it happen again with the default action
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    if (uc->uc_mcontext.gregs[REG_ERR] & X86_PF_WRITE) {
+        vga_writes++;
+        mprotect(host_vga_memory, sizeof(host_vga_memory), PROT_READ | PROT_WRITE);
+    } else {
+        vga_reads++;
+        mprotect(host_vga_memory, sizeof(host_vga_memory), PROT_READ);
+    }
+    uc->uc_mcontext.gregs[REG_EFL] |= X86_EFLAGS_TF;
+}
+
+static void vga_step(int sig, siginfo_t *info, void *context) {
+    ucontext_t *uc = context;
+
+    uc->uc_mcontext.gregs[REG_EFL] &= ~X86_EFLAGS_TF;
+    if (vga_watching) {
+        mprotect(host_vga_memory, sizeof(host_vga_memory), PROT_NONE);
+    }
+}
+
+/**
+ * Starts (and resets the counts) or stops counting video memory accesses
+ *
+ * @param watch - true to start counting, false to stop
+ */
+void host_vga_watch(bool watch) {
+    static bool installed = false;
+
+    if (!installed) {
+        struct sigaction sa = { .sa_flags = SA_SIGINFO };
+
+        sigemptyset(&sa.sa_mask);
+        sa.sa_sigaction = vga_fault;
+        sigaction(SIGSEGV, &sa, 0);
+        sa.sa_sigaction = vga_step;
+        sigaction(SIGTRAP, &sa, 0);
+        installed = true;
+    }
+
+    if (watch) {
+        vga_reads = 0;
+        vga_writes = 0;
+    }
+    vga_watching = watch;
+    mprotect(host_vga_memory, sizeof(host_vga_memory), watch ? PROT_NONE : PROT_READ | PROT_WRITE);
+}
+
+unsigned long host_vga_reads(void) {
+    return vga_reads;
+}
+
+unsigned long host_vga_writes(void) {
+    return vga_writes;
+}
+
+/**
+ * Returns a cell as displayed: relative to the CRTC start address
+ *
+ * @param row - screen row (0 to VGA_HEIGHT-1)
+ * @param col - screen column (0 to VGA_WIDTH-1)
+ */
+unsigned short host_vga_screen(int row, int col) {
+    int start = (crtc_regs[0x0C] << 8) | crtc_regs[0x0D];
+
+    return host_vga_memory[(start + row * VGA_WIDTH + col) & 0x3FFF];
+}
+
+/**
+ * Interrupts (in place of interrupts.c, which has i386 entry stubs)
+ */
+void interrupts_init(void) {
+}
+
+void interrupts_enable(void) {
+    irq_enabled = true;
+}
+
+void interrupts_disable(void) {
+    irq_enabled = false;
+}
+
+unsigned int interrupts_save(void) {
+    unsigned int flags = irq_enabled ? 0x200 : 0;
+    irq_enabled = false;
+    return flags;
+}
+
+void interrupts_restore(unsigned int flags) {
+    irq_enabled = (flags & 0x200) != 0;
+}
+
+void interrupts_irq_register(int irq, irq_handler_t handler) {
+    if (irq >= 0 && irq < IRQ_COUNT) {
+        irq_handlers[irq] = handler;
+        pic_irq_enable(irq);
+    }
+}
+
+void pic_irq_enable(int irq) {
+    unsigned short port = (irq < 8) ? 0x21 : 0xA1;
+    outportb(port, inportb(port) & ~(1 << (irq & 7)));
+}
+
+void pic_irq_disable(int irq) {
+    unsigned short port = (irq < 8) ? 0x21 : 0xA1;
+    outportb(port, inportb(port) | (1 << (irq & 7)));
+}
+
+void pic_irq_eoi(int irq) {
+    if (irq >= 8) {
+        outportb(0xA0, 0x60 | (irq & 7));
+        COUNTER_INC(COUNTER_PIC_PORT_WRITES);
+        irq = 2;
+    }
+    outportb(0x20, 0x60 | irq);
+    COUNTER_INC(COUNTER_PIC_PORT_WRITES);
+}
+
+/**
+ * Runs the handler registered for an IRQ the way interrupts_irq_handler()
+ * does, with interrupts disabled, but without switching tasks afterwards
+ *
+ * @param irq - IRQ line (0 to IRQ_COUNT-1)
+ */
+void host_irq(int irq) {
+    trapframe_t frame = { .irq = irq };
+    unsigned int flags = interrupts_save();
+
+    TRACE(TRACE_IRQ, irq, 0, 0, 0);
+    COUNTER_INC(COUNTER_IRQS);
+    if (irq_handlers[irq]) {
+        irq_handlers[irq](&frame);
+    }
+    pic_irq_eoi(irq);
+    interrupts_restore(flags);
+}
+
+bool host_interrupts_enabled(void) {
+    return irq_enabled;
+}
+
+/**
+ * SPEDE functions
+ */
+void breakpoint(void) {
+    breakpoints++;
+}
+
+int host_breakpoints(void) {
+    return breakpoints;
+}
+
+unsigned short get_cs(void) {
+    return 0x08;
+}
+
+/**
+ * Memory
+ */
+
+/**
+ * Maps memory below 4 GB and hands it to the frame allocator as its only
+ * region, in place of frame_init()
+ *
+ * @param size - bytes of memory (a multiple of FRAME_SIZE)
+ * @return address of the memory
+ */
+unsigned int host_memory_init(unsigned int size) {
+    if (HOST_MEMORY_BASE + (unsigned long)size > (unsigned long)FRAME_MAX * FRAME_SIZE) {
+        fprintf(stderr, "host: %u bytes of memory is more than the frame allocator tracks\n", size);
+        exit(2);
+    }
+    if (!memory_base) {
+        void *mem = mmap((void *)HOST_MEMORY_BASE, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (mem == MAP_FAILED) {
+            perror("host: mmap");
+            exit(2);
+        }
+        memory_base = (unsigned int)(unsigned long)mem;
+        memory_size = size;
+    } else if (size > memory_size) {
+        fprintf(stderr, "host: memory already mapped with %u bytes\n", memory_size);
+        exit(2);
+    }
+
+    frame_reset();
+    frame_region_add(memory_base, size);
+    return memory_base;
+}
+
+/**
+ * Timing and reports
+ */
+unsigned long long host_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Prints one benchmark result as "bench: <name> <value> <unit>"
+ */
+void host_bench_report(const char *name, double value, const char *unit) {
+    printf("bench: %-48s %12.2f %s\n", name, value, unit);
+}
+
+/**
+ * Discards (or stops discarding) standard output, such as the host console
+ * output of kernel_log_drain() while its throughput is measured
+ *
+ * @param quiet - true to discard output, false to restore it
+ */
+void host_quiet(bool quiet) {
+    fflush(stdout);
+    if (quiet && quiet_stdout < 0) {
+        int null = open("/dev/null", O_WRONLY);
+
+        quiet_stdout = dup(STDOUT_FILENO);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    } else if (!quiet && quiet_stdout >= 0) {
+        dup2(quiet_stdout, STDOUT_FILENO);
+        close(quiet_stdout);
+        quiet_stdout = -1;
+    }
+}
+
+/**
+ * Installs the default device models before main() runs
+ */
+__attribute__((constructor))
+static void host_init(void) {
+    host_port_device(VGA_PORT_ADDR, VGA_PORT_DATA, crtc_read, crtc_write);
+    host_port_device(0x60, 0x60, kbd_read, 0);
+    host_port_device(0x64, 0x64, kbd_read, 0);
+}
@@ -0,0 +1,128 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host Test and Benchmark Harness
+ *
+ * The kernel sources are compiled for the host against the stand-in
+ * headers in host/include. host.c supplies what the target normally does:
+ *   - an in-memory VGA_BASE (host_vga_memory)
+ *   - inportb/outportb that count every access per port and pass it to a
+ *     device model: a CRTC register file at 0x3D4/0x3D5, a keyboard
+ *     controller at 0x60/0x64, a 16550 UART at COM1 once attached, or one
+ *     registered by a test
+ *   - interrupts_* and pic_* in place of interrupts.c, with host_irq() to
+ *     run a registered IRQ handler
+ *   - memory below 4 GB for the frame allocator (host_memory_init)
+ */
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * Port I/O
+ */
+typedef unsigned char (*host_port_read_t)(unsigned short port);
+typedef void (*host_port_write_t)(unsigned short port, unsigned char value);
+
+void host_port_device(unsigned short first, unsigned short last,
+                      host_port_read_t read, host_port_write_t write);
+void host_port_reset(void);
+unsigned long host_port_reads(unsigned short port);
+unsigned long host_port_writes(unsigned short port);
+unsigned long host_port_total(void);
+
+unsigned char host_crtc_register(int index);
+
+void host_kbd_feed(const unsigned char *codes, int count);
+int host_kbd_pending(void);
+
+void host_uart_attach(void);
+int host_uart_send(int max);
+void host_uart_receive(const char *buf, int len);
+bool host_uart_irq_pending(void);
+const char *host_uart_output(int *len);
+void host_uart_output_reset(void);
+int host_uart_fifo_overruns(void);
+unsigned char host_uart_register(int reg);
+
+/**
+ * Video memory access counting
+ *
+ * While watching, every instruction that reads or writes host_vga_memory
+ * is counted (each iteration of a rep string instruction counts once), as
+ * each is a separate access to uncached video memory on the target. Bulk
+ * copies go through the host C library, so their counts depend on how its
+ * memcpy/memmove move data.
+ */
+void host_vga_watch(bool watch);
+unsigned long host_vga_reads(void);
+unsigned long host_vga_writes(void);
+unsigned short host_vga_screen(int row, int col);
+
+/**
+ * Interrupts
+ */
+void host_irq(int irq);
+bool host_interrupts_enabled(void);
+int host_breakpoints(void);
+
+/**
+ * Memory
+ */
+unsigned int host_memory_init(unsigned int size);
+
+/**
+ * Timing
+ */
+unsigned long long host_ns(void);
+
+/**
+ * Runs a statement repeatedly and returns the nanoseconds per iteration
+ *
+ * @param iterations - number of times to run the statement
+ * @param stmt - statement to time
+ */
+#define HOST_TIME(iterations, stmt)                                             \
+    ({                                                                          \
+        unsigned long long _start = host_ns();                                  \
+        for (long _i = 0; _i < (long)(iterations); _i++) {                      \
+            stmt;                                                               \
+        }                                                                       \
+        (double)(host_ns() - _start) / (double)(iterations);                    \
+    })
+
+void host_bench_report(const char *name, double value, const char *unit);
+void host_quiet(bool quiet);
+
+/**
+ * Checks
+ *
+ * A failed check is reported with its location and counted; test programs
+ * return host_failures from main() so make stops on the first failing one.
+ */
+extern int host_failures;
+
+#define HOST_CHECK(cond)                                                        \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                    #cond);                                                     \
+            host_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+#define HOST_CHECK_EQ(actual, expected)                                         \
+    do {                                                                        \
+        long long _a = (long long)(actual);                                     \
+        long long _e = (long long)(expected);                                   \
+        if (_a != _e) {                                                         \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n",   \
+                    __FILE__, __LINE__, #actual, #expected, _a, _e);            \
+            host_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+#endif
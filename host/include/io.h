@@ -0,0 +1,16 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host stand-in for io.h
+ *
+ * Port I/O is recorded by host.c instead of reaching hardware. Reads are
+ * answered by the device model registered for the port, if any.
+ */
+#ifndef IO_H
+#define IO_H
+
+unsigned char inportb(unsigned short port);
+void outportb(unsigned short port, unsigned char value);
+
+#endif
@@ -0,0 +1,20 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host stand-in for keyboard.h
+ */
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#define KEY_NULL            0x00
+#define KEY_ESCAPE          0x1B
+#define KEY_KERNEL_DEBUG    0x100
+
+void keyboard_init(void);
+unsigned int keyboard_scan(void);
+unsigned int keyboard_poll(void);
+unsigned int keyboard_getc(void);
+unsigned int keyboard_decode(unsigned int c);
+
+#endif
@@ -0,0 +1,13 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host stand-in for SPEDE's flames.h
+ */
+#ifndef SPEDE_FLAMES_H
+#define SPEDE_FLAMES_H
+
+// Counts the call instead of trapping into GDB (see host.c)
+void breakpoint(void);
+
+#endif
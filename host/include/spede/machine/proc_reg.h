@@ -0,0 +1,13 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host stand-in for SPEDE's machine/proc_reg.h
+ */
+#ifndef SPEDE_MACHINE_PROC_REG_H
+#define SPEDE_MACHINE_PROC_REG_H
+
+// Returns the kernel code segment selector used by SPEDE (see host.c)
+unsigned short get_cs(void);
+
+#endif
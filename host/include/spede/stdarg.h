@@ -0,0 +1,12 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host stand-in for SPEDE's stdarg.h
+ */
+#ifndef SPEDE_STDARG_H
+#define SPEDE_STDARG_H
+
+#include <stdarg.h>
+
+#endif
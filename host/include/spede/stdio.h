@@ -0,0 +1,16 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host stand-in for SPEDE's stdio.h
+ *
+ * SPEDE's printf goes to the host console over the debug link; on the host
+ * it is the C library's. exit() also comes from stdlib.h on SPEDE.
+ */
+#ifndef SPEDE_STDIO_H
+#define SPEDE_STDIO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#endif
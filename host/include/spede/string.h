@@ -0,0 +1,12 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host stand-in for SPEDE's string.h
+ */
+#ifndef SPEDE_STRING_H
+#define SPEDE_STRING_H
+
+#include <string.h>
+
+#endif
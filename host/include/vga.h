@@ -0,0 +1,71 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host stand-in for vga.h
+ *
+ * VGA_BASE points at an in-memory copy of the text-mode video memory
+ * (host_vga_memory in host.c) instead of 0xB8000.
+ */
+#ifndef VGA_H
+#define VGA_H
+
+#include <stdbool.h>
+
+#include "kernel.h"
+
+// 32 KB of text-mode video memory at 0xB8000 on the target
+extern unsigned short host_vga_memory[0x4000];
+
+#define VGA_BASE ((unsigned short *)host_vga_memory)
+
+#define VGA_PORT_ADDR 0x3D4
+#define VGA_PORT_DATA 0x3D5
+
+#define VGA_WIDTH 80
+#define VGA_HEIGHT 25
+
+#define VGA_CHAR(bg, fg, c) ((((bg) & 0xF) << 12) | (((fg) & 0xF) << 8) | ((c) & 0xFF))
+
+typedef enum {
+    VGA_COLOR_BLACK,
+    VGA_COLOR_BLUE,
+    VGA_COLOR_GREEN,
+    VGA_COLOR_CYAN,
+    VGA_COLOR_RED,
+    VGA_COLOR_MAGENTA,
+    VGA_COLOR_BROWN,
+    VGA_COLOR_LIGHT_GREY,
+    VGA_COLOR_DARK_GREY,
+    VGA_COLOR_LIGHT_BLUE,
+    VGA_COLOR_LIGHT_GREEN,
+    VGA_COLOR_LIGHT_CYAN,
+    VGA_COLOR_LIGHT_RED,
+    VGA_COLOR_LIGHT_MAGENTA,
+    VGA_COLOR_YELLOW,
+    VGA_COLOR_WHITE
+} vga_color_t;
+
+void vga_init(void);
+void vga_clear(void);
+void vga_clear_bg(int bg);
+void vga_clear_fg(int fg);
+void vga_cursor_enable(void);
+void vga_cursor_disable(void);
+bool vga_cursor_enabled(void);
+void vga_cursor_update(void);
+void vga_set_rowcol(int row, int col);
+int vga_get_row(void);
+int vga_get_col(void);
+void vga_set_bg(int bg);
+int vga_get_bg(void);
+void vga_set_fg(int fg);
+int vga_get_fg(void);
+void vga_setc(unsigned char c);
+void vga_putc(unsigned char c);
+void vga_puts(char *s);
+void vga_putc_at(int row, int col, int bg, int fg, unsigned char c);
+void vga_puts_at(int row, int col, int bg, int fg, char *s);
+void vga_scroll(void);
+
+#endif
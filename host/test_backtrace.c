@@ -0,0 +1,99 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: backtraces, without a symbol table
+ *
+ * No symbol table is linked in, so this also covers a kernel built
+ * without one. The backtrace is read back from the screen.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "interrupts.h"
+#include "kernel_log.h"
+#include "ksym.h"
+#include "vga.h"
+#include "host.h"
+
+// Most frames printed (KERNEL_BACKTRACE_DEPTH is 16)
+#define DEPTH 16
+
+// Return addresses into each caller along the chain, as each callee saw them
+static unsigned long ret_main;
+static unsigned long ret_a;
+static unsigned long ret_b;
+
+// The empty asm statements keep the calls out of tail position, so each
+// function keeps its frame
+static __attribute__((noinline)) void chain_c(void) {
+    ret_b = (unsigned long)__builtin_return_address(0);
+    kernel_backtrace();
+    __asm__ volatile("" ::: "memory");
+}
+
+static __attribute__((noinline)) void chain_b(void) {
+    ret_a = (unsigned long)__builtin_return_address(0);
+    chain_c();
+    __asm__ volatile("" ::: "memory");
+}
+
+static __attribute__((noinline)) void chain_a(void) {
+    ret_main = (unsigned long)__builtin_return_address(0);
+    chain_b();
+    __asm__ volatile("" ::: "memory");
+}
+
+static void row_text(int row, char *text) {
+    for (int col = 0; col < VGA_WIDTH; col++) {
+        text[col] = host_vga_screen(row, col) & 0xFF;
+    }
+    text[VGA_WIDTH] = '\0';
+}
+
+int main(void) {
+    unsigned long ret[DEPTH + 1];
+    char text[VGA_WIDTH + 1];
+    unsigned int start = 0;
+    unsigned int end = 0;
+    int frames = 0;
+    int row;
+
+    // Without a table nothing resolves
+    HOST_CHECK(ksym_lookup(0, 0) == 0);
+    HOST_CHECK(ksym_lookup((unsigned long)main, 0) == 0);
+    HOST_CHECK(!ksym_text_range(&start, &end));
+
+    host_quiet(true);
+    vga_init();
+    vga_clear();
+    vga_set_rowcol(0, 0);
+    interrupts_disable();
+    chain_a();
+    interrupts_enable();
+    host_quiet(false);
+
+    // The walk returns having printed each frame once, innermost first
+    row_text(0, text);
+    HOST_CHECK(strncmp(text, "backtrace:", 10) == 0);
+    for (row = 1; row < VGA_HEIGHT && frames <= DEPTH; row++) {
+        int depth;
+
+        row_text(row, text);
+        if (sscanf(text, " #%d 0x%lx", &depth, &ret[frames]) != 2) {
+            break;
+        }
+        HOST_CHECK_EQ(depth, frames);
+        HOST_CHECK(strstr(text, " ?+0x0") != 0);
+        frames++;
+    }
+    HOST_CHECK(frames >= 4);
+    HOST_CHECK(frames <= DEPTH);
+
+    // #0 is in chain_c, after its call to kernel_backtrace
+    HOST_CHECK_EQ(ret[1], ret_b);
+    HOST_CHECK_EQ(ret[2], ret_a);
+    HOST_CHECK_EQ(ret[3], ret_main);
+
+    return host_failures != 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: bit utilities and bitmaps against bit-at-a-time references
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "bit.h"
+#include "bitmap.h"
+#include "host.h"
+
+// Not a multiple of the word size, so the partial last word is covered
+#define NBITS   1000
+#define WORDS   ((NBITS + 31) / 32)
+#define ROUNDS  20000
+
+static unsigned int map[WORDS];
+static bool model[NBITS];
+
+static unsigned int ref_count(unsigned int value) {
+    unsigned int count = 0;
+
+    for (int bit = 0; bit < 32; bit++) {
+        count += (value >> bit) & 1;
+    }
+    return count;
+}
+
+static unsigned int ref_ffs(unsigned int value) {
+    for (int bit = 0; bit < 32; bit++) {
+        if (value & (1u << bit)) {
+            return bit + 1;
+        }
+    }
+    return 0;
+}
+
+static unsigned int ref_fls(unsigned int value) {
+    for (int bit = 31; bit >= 0; bit--) {
+        if (value & (1u << bit)) {
+            return bit + 1;
+        }
+    }
+    return 0;
+}
+
+static int ref_find(int nbits, int start, bool value) {
+    for (int bit = start; bit < nbits; bit++) {
+        if (model[bit] == value) {
+            return bit;
+        }
+    }
+    return -1;
+}
+
+static int ref_zero_run(int nbits, int start, int count) {
+    for (int bit = start; bit + count <= nbits; bit++) {
+        int len = 0;
+
+        while (len < count && !model[bit + len]) {
+            len++;
+        }
+        if (len == count) {
+            return bit;
+        }
+    }
+    return -1;
+}
+
+static unsigned int random_word(void) {
+    unsigned int value = (unsigned int)rand() << 16 ^ (unsigned int)rand();
+
+    // Sparse and dense words as well as uniform ones
+    switch (rand() % 4) {
+        case 0:  return value & (unsigned int)rand() & (unsigned int)rand();
+        case 1:  return value | (unsigned int)rand() << 8;
+        default: return value;
+    }
+}
+
+int main(void) {
+    srand(159);
+
+    // Single words
+    HOST_CHECK_EQ(bit_count(0xdecafbad), 22);
+    HOST_CHECK_EQ(bit_count(0), 0);
+    HOST_CHECK_EQ(bit_count(0xFFFFFFFF), 32);
+    HOST_CHECK_EQ(bit_ffs(0), 0);
+    HOST_CHECK_EQ(bit_fls(0), 0);
+    HOST_CHECK_EQ(bit_ffs(0x80000000), 32);
+    HOST_CHECK_EQ(bit_fls(1), 1);
+    for (int i = 0; i < ROUNDS; i++) {
+        unsigned int value = random_word();
+
+        HOST_CHECK_EQ(bit_count(value), ref_count(value));
+        HOST_CHECK_EQ(bit_ffs(value), ref_ffs(value));
+        HOST_CHECK_EQ(bit_fls(value), ref_fls(value));
+    }
+
+    // Bitmaps: random range updates checked against a bool per bit
+    for (int i = 0; i < ROUNDS; i++) {
+        int start = rand() % NBITS;
+        int count = rand() % (NBITS - start + 1);
+        int from = rand() % NBITS;
+        int run = 1 + rand() % 64;
+
+        // Mostly short ranges, which leave the map fragmented
+        if (rand() % 4) {
+            count %= 40;
+        }
+        memset(&model[start], rand() % 2, count);
+        if (model[start] || count == 0) {
+            bit_map_set_range(map, start, count);
+        } else {
+            bit_map_clear_range(map, start, count);
+        }
+
+        for (int bit = 0; bit < NBITS; bit++) {
+            if (bit_map_test(map, bit) != model[bit]) {
+                HOST_CHECK_EQ(bit_map_test(map, bit), model[bit]);
+                return 1;
+            }
+        }
+        HOST_CHECK_EQ(bit_map_find_first_zero(map, NBITS), ref_find(NBITS, 0, false));
+        HOST_CHECK_EQ(bit_map_find_next_zero(map, NBITS, from), ref_find(NBITS, from, false));
+        HOST_CHECK_EQ(bit_map_find_next_set(map, NBITS, from), ref_find(NBITS, from, true));
+        HOST_CHECK_EQ(bit_map_find_zero_run(map, NBITS, from, run), ref_zero_run(NBITS, from, run));
+        HOST_CHECK_EQ(bit_map_find_zero_run(map, NBITS, 0, run), ref_zero_run(NBITS, 0, run));
+
+        int ones = 0;
+        for (int bit = 0; bit < NBITS; bit++) {
+            ones += model[bit];
+        }
+        HOST_CHECK_EQ(bit_map_count(map, NBITS), ones);
+        if (host_failures) {
+            return 1;
+        }
+    }
+
+    // Searches stop at nbits even when the words beyond it are clear
+    memset(map, 0xFF, sizeof(map));
+    bit_map_clear_range(map, NBITS, WORDS * 32 - NBITS);
+    HOST_CHECK_EQ(bit_map_find_first_zero(map, NBITS), -1);
+    HOST_CHECK_EQ(bit_map_find_zero_run(map, NBITS, 0, 1), -1);
+    bit_map_clear_range(map, NBITS - 3, 3);
+    HOST_CHECK_EQ(bit_map_find_zero_run(map, NBITS, 0, 3), NBITS - 3);
+    HOST_CHECK_EQ(bit_map_find_zero_run(map, NBITS, 0, 4), -1);
+
+    return host_failures != 0;
+}
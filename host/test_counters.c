@@ -0,0 +1,71 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: counters overlay
+ */
+#include <string.h>
+
+#include "counters.h"
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+// Finds text on a screen row
+static bool row_has(int row, const char *text) {
+    char line[VGA_WIDTH + 1];
+
+    for (int col = 0; col < VGA_WIDTH; col++) {
+        line[col] = host_vga_screen(row, col) & 0xFF;
+    }
+    line[VGA_WIDTH] = '\0';
+    return strstr(line, text) != 0;
+}
+
+int main(void) {
+    int found = 0;
+
+    host_quiet(true);
+    vga_init();
+    host_quiet(false);
+
+    // The shell's layout: a scroll region above two pinned lines
+    vga_scroll_region(0, VGA_HEIGHT - 3);
+    vga_puts_at(VGA_HEIGHT - 2, 0, VGA_COLOR_BLACK, VGA_COLOR_WHITE, "pinned line one");
+    vga_puts_at(VGA_HEIGHT - 1, 0, VGA_COLOR_BLACK, VGA_COLOR_WHITE, "pinned line two");
+
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        counters[i] = 1000 + i;
+    }
+    host_quiet(true);
+    counters_dump();
+    host_quiet(false);
+
+    // The pinned lines are left alone
+    HOST_CHECK(row_has(VGA_HEIGHT - 2, "pinned line one"));
+    HOST_CHECK(row_has(VGA_HEIGHT - 1, "pinned line two"));
+    for (int row = VGA_HEIGHT - 2; row < VGA_HEIGHT; row++) {
+        bool overlaid = false;
+
+        for (int col = 0; col < VGA_WIDTH; col++) {
+            overlaid |= (host_vga_screen(row, col) >> 12) == VGA_COLOR_BLUE;
+        }
+        HOST_CHECK(!overlaid);
+    }
+
+    // And every counter is still shown above them
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        char value[16];
+
+        snprintf(value, sizeof(value), " %u", 1000 + i);
+        for (int row = 0; row < VGA_HEIGHT - 2; row++) {
+            if (row_has(row, value)) {
+                found++;
+                break;
+            }
+        }
+    }
+    HOST_CHECK_EQ(found, COUNTER_COUNT);
+
+    return host_failures != 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: streaming formatter against the host C library snprintf
+ *
+ * Random conversions with random flags, widths and precisions are
+ * formatted by both; only combinations C defines are generated.
+ */
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "host.h"
+
+#define ROUNDS 200000
+
+static const char *strings[] = { "", "a", "hello", "CSC 159", "a longer string of text" };
+
+// Formats with both and compares the output and the returned length
+#define SAME(size, ...)                                                         \
+    do {                                                                        \
+        char _ours[128];                                                        \
+        char _host[128];                                                        \
+        volatile int _size = (size);                                            \
+        int _n = fmt_snprintf(_ours, _size, __VA_ARGS__);                       \
+        int _m = snprintf(_host, _size, __VA_ARGS__);                           \
+        if (_n != _m || (_size > 0 && strcmp(_ours, _host) != 0)) {             \
+            fprintf(stderr, "%s:%d: format \"%s\": \"%s\" (%d) != \"%s\" (%d)\n", \
+                    __FILE__, __LINE__, spec, _ours, _n, _host, _m);            \
+            host_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+static int random_int(void) {
+    switch (rand() % 6) {
+        case 0:  return 0;
+        case 1:  return INT_MIN;
+        case 2:  return INT_MAX;
+        case 3:  return -(rand() % 1000);
+        case 4:  return rand() % 100;
+        default: return rand() - RAND_MAX / 2;
+    }
+}
+
+int main(void) {
+    char spec[32];
+    char buf[16];
+
+    srand(159);
+
+    for (int round = 0; round < ROUNDS && !host_failures; round++) {
+        static const char convs[] = "diuxXcs";
+        char conv = convs[rand() % (sizeof(convs) - 1)];
+        bool text = (conv == 'c' || conv == 's');
+        int width = rand() % 24 - 4;
+        int precision = rand() % 16 - 3;
+        int star = rand() % 4;
+        char *p = spec;
+
+        // Literal text around the conversion
+        *p++ = '<';
+        *p++ = '%';
+        if (rand() % 3 == 0) {
+            *p++ = '-';
+        }
+        if (!text && rand() % 3 == 0) {
+            *p++ = '0';
+        }
+        if (star == 1) {
+            *p++ = '*';
+        } else if (width >= 0) {
+            p += sprintf(p, "%d", width);
+        }
+        if (conv != 'c') {
+            if (star == 2) {
+                p += sprintf(p, ".*");
+            } else if (precision >= 0) {
+                p += sprintf(p, ".%d", precision);
+            }
+        }
+        *p++ = conv;
+        *p++ = '>';
+        *p = '\0';
+
+        int size = (rand() % 8) ? 128 : rand() % 12;
+        if (conv == 's') {
+            const char *s = strings[rand() % 5];
+            if (star == 1)      SAME(size, spec, width, s);
+            else if (star == 2) SAME(size, spec, precision, s);
+            else                SAME(size, spec, s);
+        } else {
+            int value = (conv == 'c') ? 'A' + rand() % 26 : random_int();
+            if (star == 1)      SAME(size, spec, width, value);
+            else if (star == 2) SAME(size, spec, precision, value);
+            else                SAME(size, spec, value);
+        }
+    }
+
+    // Fixed cases
+    strcpy(spec, "several");
+    SAME(128, "%d %s %x %c %% %u", -42, "and", 0xbeef, '!', 7u);
+    SAME(128, "%-8s|%8s|%.2s|", "ab", "cd", "efgh");
+    SAME(128, "%08x %08X %.8x", 0xdecaf, 0xdecaf, 0xdecaf);
+    SAME(128, "%ld %lu %hd", 5L, 6UL, (short)7);
+    SAME(128, "%s", "");
+    SAME(128, "no conversions at all");
+    SAME(1, "%d", 12345);
+    SAME(0, "%d", 12345);
+
+    // Conversions the host formats differently
+    HOST_CHECK_EQ(fmt_snprintf(buf, sizeof(buf), "%p", (void *)0x1234), 6);
+    HOST_CHECK(strcmp(buf, "0x1234") == 0);
+    fmt_snprintf(buf, sizeof(buf), "%s", (char *)0);
+    HOST_CHECK(strcmp(buf, "(null)") == 0);
+    HOST_CHECK_EQ(fmt_snprintf(buf, sizeof(buf), "%q%"), 2);
+    HOST_CHECK(strcmp(buf, "%q") == 0);
+
+    // Truncation keeps the NUL and reports the full length
+    memset(buf, 'x', sizeof(buf));
+    HOST_CHECK_EQ(fmt_snprintf(buf, 5, "%s-%d", "abcdef", 12), 9);
+    HOST_CHECK(strcmp(buf, "abcd") == 0);
+    HOST_CHECK_EQ(buf[5], 'x');
+
+    return host_failures != 0;
+}
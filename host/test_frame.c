@@ -0,0 +1,220 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: physical frame allocator
+ *
+ * Random alloc/free churn is checked against a model of which frames are
+ * in use, and every allocation is filled with a pattern that must still
+ * be there when it is freed.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "counters.h"
+#include "frame.h"
+#include "host.h"
+
+#define MEMORY      (8 * 1024 * 1024)
+#define FRAMES      (MEMORY / FRAME_SIZE)
+#define ROUNDS      200000
+#define LIVE_MAX    1024
+
+// Most frames frame_init reserves around the boot stack
+#define STACK_FRAMES (2 * FRAME_BOOT_STACK_SIZE / FRAME_SIZE + 1)
+
+// End of the program image (provided by the linker)
+extern char end[];
+
+typedef struct allocation {
+    unsigned int addr;
+    int count;
+} allocation_t;
+
+static unsigned int base;
+static bool used[FRAMES];
+static int used_count = 0;
+static allocation_t live[LIVE_MAX];
+static int live_count = 0;
+
+// CMOS model: extended memory size registers
+static unsigned int cmos_ext_kb = 0;
+static unsigned int cmos_high_blocks = 0;
+static unsigned char cmos_index = 0;
+
+static unsigned char cmos_read(unsigned short port) {
+    switch (cmos_index) {
+        case 0x30: return cmos_ext_kb & 0xFF;
+        case 0x31: return cmos_ext_kb >> 8;
+        case 0x34: return cmos_high_blocks & 0xFF;
+        case 0x35: return cmos_high_blocks >> 8;
+        default:   return 0;
+    }
+}
+
+static void cmos_write(unsigned short port, unsigned char value) {
+    if (port == 0x70) {
+        cmos_index = value;
+    }
+}
+
+static void track(unsigned int addr, int count) {
+    int frame = (addr - base) / FRAME_SIZE;
+
+    HOST_CHECK(addr >= base && addr % FRAME_SIZE == 0);
+    HOST_CHECK(frame + count <= FRAMES);
+    for (int i = frame; i < frame + count; i++) {
+        HOST_CHECK(!used[i]);
+        used[i] = true;
+    }
+    used_count += count;
+
+    memset((void *)(unsigned long)addr, live_count & 0xFF, count * FRAME_SIZE);
+    live[live_count].addr = addr;
+    live[live_count].count = count;
+    live_count++;
+}
+
+static void release(int index) {
+    allocation_t a = live[index];
+    unsigned char *p = (unsigned char *)(unsigned long)a.addr;
+    int frame = (a.addr - base) / FRAME_SIZE;
+
+    // Check the first and last byte of every frame
+    for (int i = 0; i < a.count; i++) {
+        HOST_CHECK_EQ(p[i * FRAME_SIZE], index & 0xFF);
+        HOST_CHECK_EQ(p[(i + 1) * FRAME_SIZE - 1], index & 0xFF);
+        used[frame + i] = false;
+    }
+    used_count -= a.count;
+    frame_free_contig(a.addr, a.count);
+
+    // Keep the pattern of each allocation matching its index
+    live_count--;
+    if (index != live_count) {
+        live[index] = live[live_count];
+        memset((void *)(unsigned long)live[index].addr, index & 0xFF,
+               live[index].count * FRAME_SIZE);
+    }
+}
+
+// Frames frame_init adds from the end of the program image up to top
+static int frames_below(unsigned int top) {
+    return top / FRAME_SIZE - ((unsigned int)(unsigned long)end + FRAME_SIZE - 1) / FRAME_SIZE;
+}
+
+static int largest_run(void) {
+    int largest = 0;
+    int run = 0;
+
+    for (int i = 0; i < FRAMES; i++) {
+        run = used[i] ? 0 : run + 1;
+        if (run > largest) {
+            largest = run;
+        }
+    }
+    return largest;
+}
+
+int main(void) {
+    frame_stats_t stats;
+    unsigned int errors;
+
+    srand(159);
+    base = host_memory_init(MEMORY);
+    frame_stats(&stats);
+    HOST_CHECK_EQ(stats.total, FRAMES);
+    HOST_CHECK_EQ(stats.free, FRAMES);
+    HOST_CHECK_EQ(stats.largest_free_run, FRAMES);
+    HOST_CHECK_EQ(stats.fragmentation, 0);
+
+    // Churn: mostly single frames, some runs, frees in random order
+    for (int round = 0; round < ROUNDS; round++) {
+        if (live_count < LIVE_MAX && (live_count == 0 || rand() % 100 < 52)) {
+            int count = (rand() % 8) ? 1 : 2 + rand() % 15;
+            unsigned int addr = (count == 1) ? frame_alloc() : frame_alloc_contig(count);
+
+            if (addr) {
+                track(addr, count);
+            } else {
+                HOST_CHECK(count > 1 && largest_run() < count);
+            }
+        } else {
+            release(rand() % live_count);
+        }
+
+        if (round % 1000 == 0) {
+            frame_stats(&stats);
+            HOST_CHECK_EQ(stats.free, FRAMES - used_count);
+            HOST_CHECK_EQ(stats.largest_free_run, largest_run());
+        }
+        if (host_failures) {
+            return 1;
+        }
+    }
+    while (live_count) {
+        release(live_count - 1);
+    }
+    frame_stats(&stats);
+    HOST_CHECK_EQ(stats.free, FRAMES);
+    HOST_CHECK_EQ(stats.largest_free_run, FRAMES);
+
+    // Bad frees are reported and change nothing
+    host_quiet(true);
+    errors = counters[COUNTER_LOG_ERROR];
+    frame_free(base);
+    frame_free(base + 1);
+    frame_free(0);
+    host_quiet(false);
+    HOST_CHECK_EQ(counters[COUNTER_LOG_ERROR], errors + 3);
+    frame_stats(&stats);
+    HOST_CHECK_EQ(stats.free, FRAMES);
+
+    // Exhaustion: every frame once, then nothing
+    for (int i = 0; i < FRAMES; i++) {
+        unsigned int addr = frame_alloc();
+
+        HOST_CHECK(addr >= base && addr < base + MEMORY);
+        if (!addr) {
+            break;
+        }
+    }
+    HOST_CHECK_EQ(frame_alloc(), 0);
+    HOST_CHECK_EQ(frame_alloc_contig(2), 0);
+
+    // Reserved frames are never handed out, even those only partly covered
+    host_memory_init(MEMORY);
+    frame_region_reserve(base + 10 * FRAME_SIZE + 1, 2 * FRAME_SIZE);
+    frame_stats(&stats);
+    HOST_CHECK_EQ(stats.total, FRAMES - 3);
+    HOST_CHECK_EQ(stats.free, FRAMES - 3);
+    for (unsigned int addr; (addr = frame_alloc()) != 0; ) {
+        HOST_CHECK(addr < base + 10 * FRAME_SIZE || addr >= base + 13 * FRAME_SIZE);
+    }
+
+    // frame_init uses the installed memory from the CMOS, up to
+    // FRAME_MEMORY_END (the host stack may take a few frames away)
+    host_port_device(0x70, 0x71, cmos_read, cmos_write);
+    host_quiet(true);
+    cmos_ext_kb = 7 * 1024;
+    frame_init();
+    frame_stats(&stats);
+    HOST_CHECK(stats.total <= frames_below(0x800000));
+    HOST_CHECK(stats.total >= frames_below(0x800000) - STACK_FRAMES);
+
+    // Above 16 MB the size is in 64 KB blocks
+    cmos_high_blocks = 0x80;
+    frame_init();
+    frame_stats(&stats);
+    HOST_CHECK(stats.total <= frames_below(0x1800000));
+    HOST_CHECK(stats.total >= frames_below(0x1800000) - STACK_FRAMES);
+
+    cmos_high_blocks = 0x1000;
+    frame_init();
+    frame_stats(&stats);
+    HOST_CHECK(stats.total <= frames_below(FRAME_MEMORY_END));
+    HOST_CHECK(stats.total >= frames_below(FRAME_MEMORY_END) - STACK_FRAMES);
+    host_quiet(false);
+
+    return host_failures != 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: keyboard interrupt handler and bottom half under scancode bursts
+ *
+ * Scancodes are fed to the keyboard controller model, the keyboard IRQ is
+ * raised and the work queue is run by hand, as the workq task would.
+ */
+#include "counters.h"
+#include "interrupts.h"
+#include "keyboard.h"
+#include "keyboard_ext.h"
+#include "ring.h"
+#include "workq.h"
+#include "host.h"
+
+#define MAKE(code)      (code)
+#define BREAK(code)     ((code) | 0x80)
+
+#define SC_H            0x23
+#define SC_E            0x12
+#define SC_L            0x26
+#define SC_O            0x18
+#define SC_A            0x1E
+#define SC_LSHIFT       0x2A
+
+// Feeds the make and break codes of each scancode in turn
+static void type(const unsigned char *codes, int count) {
+    for (int i = 0; i < count; i++) {
+        unsigned char burst[2] = { MAKE(codes[i]), BREAK(codes[i]) };
+        host_kbd_feed(burst, 2);
+    }
+}
+
+// Returns how many work items have been queued so far
+static unsigned int queued(void) {
+    workq_stats_t stats;
+
+    workq_stats(&stats);
+    return stats.queued;
+}
+
+int main(void) {
+    static const unsigned char hello[] = { SC_H, SC_E, SC_L, SC_L, SC_O };
+    unsigned int items;
+
+    host_quiet(true);
+    keyboard_init();
+    host_quiet(false);
+
+    // One interrupt drains the whole burst with one status read per
+    // scancode plus the one that ends the loop
+    type(hello, 5);
+    host_port_reset();
+    items = queued();
+    host_irq(IRQ_KEYBOARD);
+    HOST_CHECK_EQ(host_kbd_pending(), 0);
+    HOST_CHECK_EQ(host_port_reads(0x60), 10);
+    HOST_CHECK_EQ(host_port_reads(0x64), 11);
+    HOST_CHECK_EQ(queued(), items + 1);
+
+    // Nothing is decoded until the bottom half runs
+    HOST_CHECK_EQ(keyboard_poll(), KEY_NULL);
+    workq_run(0);
+    HOST_CHECK_EQ(keyboard_poll(), 'h');
+    HOST_CHECK_EQ(keyboard_poll(), 'e');
+    HOST_CHECK_EQ(keyboard_poll(), 'l');
+    HOST_CHECK_EQ(keyboard_poll(), 'l');
+    HOST_CHECK_EQ(keyboard_poll(), 'o');
+    HOST_CHECK_EQ(keyboard_poll(), KEY_NULL);
+
+    // Interrupts arriving before the bottom half runs do not queue it again,
+    // and modifier state carries across interrupts
+    items = queued();
+    host_kbd_feed((unsigned char[]){ MAKE(SC_LSHIFT) }, 1);
+    host_irq(IRQ_KEYBOARD);
+    type(hello, 2);
+    host_irq(IRQ_KEYBOARD);
+    host_kbd_feed((unsigned char[]){ BREAK(SC_LSHIFT) }, 1);
+    host_irq(IRQ_KEYBOARD);
+    type(hello + 2, 3);
+    host_irq(IRQ_KEYBOARD);
+    HOST_CHECK_EQ(queued(), items + 1);
+    workq_run(0);
+    HOST_CHECK_EQ(keyboard_poll(), 'H');
+    HOST_CHECK_EQ(keyboard_poll(), 'E');
+    HOST_CHECK_EQ(keyboard_poll(), 'l');
+    HOST_CHECK_EQ(keyboard_poll(), 'l');
+    HOST_CHECK_EQ(keyboard_poll(), 'o');
+    HOST_CHECK_EQ(keyboard_poll(), KEY_NULL);
+
+    // A scancode arriving while the bottom half drains queues a new run
+    items = queued();
+    type(hello, 1);
+    host_irq(IRQ_KEYBOARD);
+    workq_run(0);
+    type(hello + 1, 1);
+    host_irq(IRQ_KEYBOARD);
+    HOST_CHECK_EQ(queued(), items + 2);
+    workq_run(0);
+    HOST_CHECK_EQ(keyboard_poll(), 'h');
+    HOST_CHECK_EQ(keyboard_poll(), 'e');
+    HOST_CHECK_EQ(keyboard_poll(), KEY_NULL);
+
+    // A burst larger than the scancode ring in one interrupt: the ring
+    // keeps the first RING_SIZE scancodes and counts the rest as dropped
+    {
+        unsigned char burst[RING_SIZE + 44];
+        unsigned int drops = counters[COUNTER_KBD_DROPS];
+        unsigned int warnings;
+        int keys = 0;
+
+        for (int i = 0; i < (int)sizeof(burst); i++) {
+            burst[i] = MAKE(SC_A);
+        }
+        host_kbd_feed(burst, sizeof(burst));
+        host_irq(IRQ_KEYBOARD);
+        HOST_CHECK_EQ(host_kbd_pending(), 0);
+        HOST_CHECK_EQ(keyboard_overflows(), 44);
+        HOST_CHECK_EQ(counters[COUNTER_KBD_DROPS], drops + 44);
+
+        // The rest are decoded (typematic repeats) and the drop is reported
+        // by the first poll only
+        workq_run(0);
+        host_quiet(true);
+        warnings = counters[COUNTER_LOG_WARN];
+        while (keyboard_poll() == 'a') {
+            keys++;
+        }
+        HOST_CHECK_EQ(counters[COUNTER_LOG_WARN], warnings + 1);
+        HOST_CHECK_EQ(keyboard_poll(), KEY_NULL);
+        HOST_CHECK_EQ(counters[COUNTER_LOG_WARN], warnings + 1);
+        host_quiet(false);
+        HOST_CHECK_EQ(keys, RING_SIZE);
+
+        host_kbd_feed((unsigned char[]){ BREAK(SC_A) }, 1);
+        host_irq(IRQ_KEYBOARD);
+        workq_run(0);
+    }
+
+    // The keyboard keeps working after an overflow
+    type(hello, 5);
+    host_irq(IRQ_KEYBOARD);
+    workq_run(0);
+    for (int i = 0; i < 5; i++) {
+        HOST_CHECK_EQ(keyboard_poll(), "hello"[i]);
+    }
+    HOST_CHECK_EQ(keyboard_poll(), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_overflows(), 44);
+
+    return host_failures != 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: table-driven scancode decoder
+ */
+#include "counters.h"
+#include "keyboard.h"
+#include "host.h"
+
+#define BREAK(code)     ((code) | 0x80)
+
+#define SC_1            0x02
+#define SC_A            0x1E
+#define SC_R            0x13
+#define SC_SLASH        0x35
+#define SC_ENTER        0x1C
+#define SC_KEYPAD_7     0x47
+#define SC_CTRL         0x1D
+#define SC_LSHIFT       0x2A
+#define SC_RSHIFT       0x36
+#define SC_CAPS         0x3A
+#define SC_NUMLOCK      0x45
+#define SC_EXTENDED     0xE0
+
+// Decodes the make code of a key, checks its break code produces nothing
+static unsigned int press(unsigned int code) {
+    unsigned int key = keyboard_decode(code);
+
+    HOST_CHECK_EQ(keyboard_decode(BREAK(code)), KEY_NULL);
+    return key;
+}
+
+// Presses and releases a toggle key
+static void toggle(unsigned int code) {
+    HOST_CHECK_EQ(press(code), KEY_NULL);
+}
+
+int main(void) {
+    // Plain keys
+    HOST_CHECK_EQ(press(SC_A), 'a');
+    HOST_CHECK_EQ(press(SC_1), '1');
+    HOST_CHECK_EQ(press(SC_SLASH), '/');
+    HOST_CHECK_EQ(press(SC_ENTER), '\n');
+    HOST_CHECK_EQ(press(SC_KEYPAD_7), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(0x7F), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(0x100), KEY_NULL);
+
+    // SHIFT (either one) while held
+    HOST_CHECK_EQ(keyboard_decode(SC_LSHIFT), KEY_NULL);
+    HOST_CHECK_EQ(press(SC_A), 'A');
+    HOST_CHECK_EQ(press(SC_1), '!');
+    HOST_CHECK_EQ(keyboard_decode(BREAK(SC_LSHIFT)), KEY_NULL);
+    HOST_CHECK_EQ(press(SC_SLASH), '/');
+    HOST_CHECK_EQ(keyboard_decode(SC_RSHIFT), KEY_NULL);
+    HOST_CHECK_EQ(press(SC_SLASH), '?');
+    HOST_CHECK_EQ(keyboard_decode(BREAK(SC_RSHIFT)), KEY_NULL);
+    HOST_CHECK_EQ(press(SC_A), 'a');
+
+    // CAPS only affects letters, SHIFT inverts it, typematic repeats of
+    // the CAPS key do not toggle it again
+    HOST_CHECK_EQ(keyboard_decode(SC_CAPS), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(SC_CAPS), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(BREAK(SC_CAPS)), KEY_NULL);
+    HOST_CHECK_EQ(press(SC_A), 'A');
+    HOST_CHECK_EQ(press(SC_1), '1');
+    HOST_CHECK_EQ(keyboard_decode(SC_LSHIFT), KEY_NULL);
+    HOST_CHECK_EQ(press(SC_A), 'a');
+    HOST_CHECK_EQ(press(SC_1), '!');
+    HOST_CHECK_EQ(keyboard_decode(BREAK(SC_LSHIFT)), KEY_NULL);
+    toggle(SC_CAPS);
+    HOST_CHECK_EQ(press(SC_A), 'a');
+
+    // NUMLOCK selects the keypad digits
+    toggle(SC_NUMLOCK);
+    HOST_CHECK_EQ(press(SC_KEYPAD_7), '7');
+    HOST_CHECK_EQ(press(SC_A), 'a');
+    toggle(SC_NUMLOCK);
+    HOST_CHECK_EQ(press(SC_KEYPAD_7), KEY_NULL);
+
+    // Extended keys: keypad enter and slash map to the main keys, the
+    // "fake" shifts sent around them do not change the modifier state,
+    // and the prefix only applies to the next scancode
+    HOST_CHECK_EQ(keyboard_decode(SC_EXTENDED), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(SC_LSHIFT), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(SC_EXTENDED), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(SC_SLASH), '/');
+    HOST_CHECK_EQ(keyboard_decode(SC_EXTENDED), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(BREAK(SC_SLASH)), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(SC_EXTENDED), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(BREAK(SC_LSHIFT)), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(SC_EXTENDED), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(SC_ENTER), '\n');
+    HOST_CHECK_EQ(keyboard_decode(SC_EXTENDED), KEY_NULL);
+    HOST_CHECK_EQ(keyboard_decode(SC_KEYPAD_7), KEY_NULL);
+    HOST_CHECK_EQ(press(SC_A), 'a');
+
+    // The debug chord hands the key to kernel_command instead (CTRL+R
+    // resets the counters) and produces no key itself
+    counters[COUNTER_KBD_EVENTS] = 5;
+    HOST_CHECK_EQ(keyboard_decode(SC_CTRL), KEY_NULL);
+    HOST_CHECK_EQ(press(SC_R), KEY_NULL);
+    HOST_CHECK_EQ(counters[COUNTER_KBD_EVENTS], 0);
+    HOST_CHECK_EQ(keyboard_decode(BREAK(SC_CTRL)), KEY_NULL);
+    HOST_CHECK_EQ(press(SC_R), 'r');
+
+    return host_failures != 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: kernel symbol lookup
+ *
+ * The table is defined here, in place of the one tools/ksymgen.sh
+ * generates. A kernel linked without a table is covered by
+ * test_backtrace.c, which links none.
+ */
+#include <string.h>
+
+#include "ksym.h"
+#include "host.h"
+
+const char ksym_names[] = "start\0main\0kernel_init\0last";
+const ksym_t ksym_table[] = {
+    { 0x1000, 0 },
+    { 0x1010, 6 },
+    { 0x1080, 11 },
+    { 0x1100, 23 },
+};
+const unsigned int ksym_count = sizeof(ksym_table) / sizeof(ksym_table[0]);
+const unsigned int ksym_text_end = 0x1180;
+
+// Checks that an address resolves to a symbol at an offset
+static bool resolves(unsigned int addr, const char *name, unsigned int offset) {
+    unsigned int found = ~0U;
+    const char *sym = ksym_lookup(addr, &found);
+
+    return sym && strcmp(sym, name) == 0 && found == offset;
+}
+
+int main(void) {
+    unsigned int start = 0;
+    unsigned int end = 0;
+    bool agree = true;
+
+    // Below the first symbol, and from the end of the text on, nothing
+    HOST_CHECK(ksym_lookup(0, 0) == 0);
+    HOST_CHECK(ksym_lookup(0x0FFF, 0) == 0);
+    HOST_CHECK(ksym_lookup(0x1180, 0) == 0);
+    HOST_CHECK(ksym_lookup(0xFFFFFFFF, 0) == 0);
+
+    // The exact start of each symbol, and the last byte before the next
+    HOST_CHECK(resolves(0x1000, "start", 0));
+    HOST_CHECK(resolves(0x100F, "start", 0xF));
+    HOST_CHECK(resolves(0x1010, "main", 0));
+    HOST_CHECK(resolves(0x107F, "main", 0x6F));
+    HOST_CHECK(resolves(0x1080, "kernel_init", 0));
+
+    // The last symbol runs up to the end of the text
+    HOST_CHECK(resolves(0x1100, "last", 0));
+    HOST_CHECK(resolves(0x117F, "last", 0x7F));
+
+    // The offset is optional
+    HOST_CHECK(strcmp(ksym_lookup(0x1011, 0), "main") == 0);
+
+    // Every address in the text agrees with a linear scan of the table
+    for (unsigned int addr = 0x1000; addr < ksym_text_end; addr++) {
+        unsigned int i = ksym_count - 1;
+
+        while (ksym_table[i].addr > addr) {
+            i--;
+        }
+        agree &= resolves(addr, &ksym_names[ksym_table[i].name], addr - ksym_table[i].addr);
+    }
+    HOST_CHECK(agree);
+
+    HOST_CHECK(ksym_text_range(&start, &end));
+    HOST_CHECK_EQ(start, 0x1000);
+    HOST_CHECK_EQ(end, 0x1180);
+
+    return host_failures != 0;
+}
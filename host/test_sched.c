@@ -0,0 +1,77 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: round-robin scheduling on interrupt exit
+ *
+ * Switches are driven by calling sched_irq_exit() as the interrupt entry
+ * code does; the spawned tasks never actually run.
+ */
+#include <string.h>
+
+#include "interrupts.h"
+#include "sched.h"
+#include "timer.h"
+#include "host.h"
+
+static void task(void *arg) {
+}
+
+// Switches to the next task and checks which one it is
+static trapframe_t *expect(trapframe_t *frame, const char *name) {
+    sched_preempt();
+    frame = sched_irq_exit(frame);
+    HOST_CHECK(strcmp(sched_current()->name, name) == 0);
+    HOST_CHECK(frame == sched_current()->frame);
+    return frame;
+}
+
+int main(void) {
+    trapframe_t boot_frame = { 0 };
+    trapframe_t *frame = &boot_frame;
+    task_t *a;
+    task_t *b;
+    task_t *c;
+
+    host_memory_init(256 * 1024);
+    host_quiet(true);
+    sched_init();
+    timer_init(TIMER_HZ);
+    a = sched_spawn("a", task, 0);
+    b = sched_spawn("b", task, 0);
+    c = sched_spawn("c", task, 0);
+    host_quiet(false);
+    HOST_CHECK(a && b && c);
+    HOST_CHECK(strcmp(sched_current()->name, "shell") == 0);
+
+    // New tasks start at sched_task_start on their own stacks, with
+    // interrupts enabled
+    HOST_CHECK((unsigned int)(unsigned long)a->frame > a->stack);
+    HOST_CHECK((unsigned int)(unsigned long)a->frame < a->stack + 4096);
+    HOST_CHECK(a->frame->eflags & 0x200);
+
+    // Without a request, an interrupt exit resumes the interrupted task
+    HOST_CHECK(sched_irq_exit(frame) == frame);
+
+    // Round robin, the boot task included, and its frame is handed back
+    frame = expect(frame, "a");
+    frame = expect(frame, "b");
+    frame = expect(frame, "c");
+    frame = expect(frame, "shell");
+    HOST_CHECK(frame == &boot_frame);
+    frame = expect(frame, "a");
+    HOST_CHECK_EQ(a->switches, 2);
+
+    // Timer ticks switch once the quantum is used up
+    for (int tick = 1; tick < SCHED_QUANTUM; tick++) {
+        host_irq(IRQ_TIMER);
+        frame = sched_irq_exit(frame);
+        HOST_CHECK(sched_current() == a);
+    }
+    host_irq(IRQ_TIMER);
+    frame = sched_irq_exit(frame);
+    HOST_CHECK(sched_current() == b);
+    HOST_CHECK_EQ(a->ticks, SCHED_QUANTUM);
+
+    return host_failures != 0;
+}
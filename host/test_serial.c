@@ -0,0 +1,193 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: interrupt-driven serial driver against a 16550 UART model
+ */
+#include <string.h>
+
+#include "counters.h"
+#include "interrupts.h"
+#include "keyboard.h"
+#include "serial.h"
+#include "vga_ext.h"
+#include "workq.h"
+#include "host.h"
+
+// A floating bus: no device answers at COM1
+static unsigned char absent_read(unsigned short port) {
+    return 0xFF;
+}
+
+// Lets the line send everything, taking each interrupt the UART raises
+static int drain(void) {
+    int irqs = 0;
+
+    while (host_uart_send(16) > 0 || host_uart_irq_pending()) {
+        if (host_uart_irq_pending()) {
+            host_irq(IRQ_COM1);
+            irqs++;
+        }
+    }
+    return irqs;
+}
+
+// Checks the bytes sent since the last check
+static bool output_is(const char *expected, int len) {
+    int n;
+    const char *out = host_uart_output(&n);
+    bool same = (n == len && memcmp(out, expected, len) == 0);
+
+    host_uart_output_reset();
+    return same;
+}
+
+int main(void) {
+    serial_stats_t stats;
+    char msg[1000];
+    int irqs;
+    int queued;
+
+    // No UART: writes are discarded
+    host_port_device(SERIAL_COM1, SERIAL_COM1 + 7, absent_read, 0);
+    host_quiet(true);
+    serial_init();
+    host_quiet(false);
+    HOST_CHECK(!serial_present());
+    HOST_CHECK_EQ(serial_write("lost", 4), 0);
+
+    // The UART is programmed for 8N1 at SERIAL_BAUD with the receive
+    // interrupts on and the transmit interrupt off while nothing is queued
+    host_uart_attach();
+    host_quiet(true);
+    keyboard_init();
+    serial_init();
+    host_quiet(false);
+    HOST_CHECK(serial_present());
+    HOST_CHECK_EQ(host_uart_register(0) | host_uart_register(1) << 8, 115200 / SERIAL_BAUD);
+    HOST_CHECK_EQ(host_uart_register(3), 0x03);
+    HOST_CHECK_EQ(host_uart_register(4), 0x0B);
+    HOST_CHECK_EQ(host_uart_register(2), 0x05);
+
+    // A short write goes straight into the idle FIFO, '\n' as "\r\n"
+    HOST_CHECK_EQ(serial_write("hello\n", 6), 6);
+    HOST_CHECK_EQ(host_uart_register(2) & 0x02, 0);
+    irqs = drain();
+    HOST_CHECK_EQ(irqs, 0);
+    HOST_CHECK(output_is("hello\r\n", 7));
+
+    // A long write is sent in FIFO-sized bursts, one per THRE interrupt,
+    // without ever overrunning the FIFO
+    for (int i = 0; i < (int)sizeof(msg); i++) {
+        msg[i] = 'a' + i % 26;
+    }
+    serial_stats(&stats);
+    unsigned int bursts = stats.tx_bursts;
+    HOST_CHECK_EQ(serial_write(msg, sizeof(msg)), sizeof(msg));
+    HOST_CHECK(host_uart_register(2) & 0x02);
+    irqs = drain();
+    HOST_CHECK(output_is(msg, sizeof(msg)));
+    HOST_CHECK_EQ(irqs, (sizeof(msg) + 15) / 16 - 1);
+    serial_stats(&stats);
+    HOST_CHECK_EQ(stats.tx_bursts - bursts, (sizeof(msg) + 15) / 16);
+    HOST_CHECK_EQ(host_uart_register(2) & 0x02, 0);
+    HOST_CHECK_EQ(host_uart_fifo_overruns(), 0);
+
+    // Writes queued while the line is busy are sent in order
+    serial_write("one ", 4);
+    serial_write("two ", 4);
+    host_uart_send(2);
+    serial_write("three", 5);
+    drain();
+    HOST_CHECK(output_is("one two three", 13));
+
+    // A write larger than the ring keeps what fits and counts the rest
+    {
+        static char big[SERIAL_TX_SIZE + 1000];
+        unsigned int drops = counters[COUNTER_SERIAL_TX_DROPS];
+
+        memset(big, 'x', sizeof(big));
+        queued = serial_write(big, sizeof(big));
+        HOST_CHECK_EQ(queued, SERIAL_TX_SIZE);
+        HOST_CHECK_EQ(counters[COUNTER_SERIAL_TX_DROPS] - drops, sizeof(big) - queued);
+
+        // Only the 16 bytes that moved on to the FIFO have been freed
+        HOST_CHECK_EQ(serial_write(big, 100), 16);
+        serial_stats(&stats);
+        HOST_CHECK_EQ(counters[COUNTER_SERIAL_TX_DROPS] - drops, sizeof(big) - queued + 84);
+        HOST_CHECK_EQ(stats.tx_drops, counters[COUNTER_SERIAL_TX_DROPS]);
+        drain();
+        HOST_CHECK(output_is(big, queued + 16));
+
+        // Room again once the line has caught up
+        HOST_CHECK_EQ(serial_write("z", 1), 1);
+        drain();
+        HOST_CHECK(output_is("z", 1));
+    }
+
+    // serial_flush sends everything by polling, without interrupts
+    serial_write(msg, 100);
+    {
+        int n;
+
+        host_uart_send(16);
+        host_uart_output(&n);
+        HOST_CHECK_EQ(n, 16);
+    }
+    host_port_reset();
+    // The line keeps up with the polling: each LSR read sees an empty FIFO
+    while (host_port_writes(SERIAL_COM1) < 84) {
+        int before = host_port_writes(SERIAL_COM1);
+
+        serial_flush();
+        host_uart_send(16);
+        if (host_port_writes(SERIAL_COM1) == before) {
+            break;
+        }
+    }
+    HOST_CHECK_EQ(host_port_writes(SERIAL_COM1), 84);
+    host_uart_send(16);
+    HOST_CHECK(output_is(msg, 100));
+
+    // Received bytes become keys, with CR as newline and DEL as backspace
+    host_uart_receive("hi\r\x7f", 4);
+    host_irq(IRQ_COM1);
+    workq_run(0);
+    HOST_CHECK_EQ(keyboard_poll(), 'h');
+    HOST_CHECK_EQ(keyboard_poll(), 'i');
+    HOST_CHECK_EQ(keyboard_poll(), '\n');
+    HOST_CHECK_EQ(keyboard_poll(), '\b');
+    HOST_CHECK_EQ(keyboard_poll(), KEY_NULL);
+
+    // Bytes lost in the UART before the interrupt is taken are counted
+    serial_stats(&stats);
+    unsigned int overruns = stats.rx_overruns;
+    unsigned int received = stats.rx_bytes;
+    host_uart_receive("0123456789abcdefXYZ", 19);
+    host_irq(IRQ_COM1);
+    workq_run(0);
+    serial_stats(&stats);
+    HOST_CHECK_EQ(stats.rx_overruns - overruns, 1);
+    HOST_CHECK_EQ(stats.rx_bytes - received, 16);
+    for (int i = 0; i < 16; i++) {
+        HOST_CHECK_EQ(keyboard_poll(), "0123456789abcdef"[i]);
+    }
+    HOST_CHECK(!host_uart_irq_pending());
+
+    // The VGA register dump of a panic also goes out the serial port
+    {
+        int n;
+        const char *out;
+
+        host_uart_output_reset();
+        host_quiet(true);
+        vga_dump_registers();
+        host_quiet(false);
+        serial_flush();
+        drain();
+        out = host_uart_output(&n);
+        HOST_CHECK(n > 16 && memcmp(out, "vga: crtc\r\n  00:", 16) == 0);
+    }
+
+    return host_failures != 0;
+}
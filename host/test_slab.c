@@ -0,0 +1,164 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: slab caches and arenas
+ */
+#include <string.h>
+
+#include "counters.h"
+#include "frame.h"
+#include "kernel.h"
+#include "slab.h"
+#include "host.h"
+
+#define MEMORY      (4 * 1024 * 1024)
+#define OBJECTS     5000
+#define OBJ_SIZE    24
+
+static unsigned char *objs[OBJECTS];
+
+// Fills an object with a byte pattern derived from its index
+static void fill(int i, int size) {
+    memset(objs[i], i * 7 + 1, size);
+}
+
+static bool intact(int i, int size) {
+    for (int b = 0; b < size; b++) {
+        if (objs[i][b] != (unsigned char)(i * 7 + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void) {
+    slab_cache_t cache;
+    slab_cache_t big;
+    frame_stats_t stats;
+    unsigned int base;
+    unsigned int errors;
+    int per_frame;
+
+    base = host_memory_init(MEMORY);
+    host_quiet(true);
+    slab_init();
+    host_quiet(false);
+
+    // Objects are distinct, aligned, inside the allocator's memory and
+    // never overlap
+    HOST_CHECK(slab_cache_init(&cache, "test", OBJ_SIZE));
+    for (int i = 0; i < OBJECTS; i++) {
+        objs[i] = slab_alloc(&cache);
+        HOST_CHECK(objs[i] != 0);
+        HOST_CHECK((unsigned long)objs[i] % 8 == 0);
+        HOST_CHECK((unsigned long)objs[i] >= base && (unsigned long)objs[i] < base + MEMORY);
+        fill(i, OBJ_SIZE);
+    }
+    for (int i = 0; i < OBJECTS; i++) {
+        HOST_CHECK(intact(i, OBJ_SIZE));
+    }
+
+    // Occupancy counters
+    per_frame = (FRAME_SIZE - 8) / OBJ_SIZE;
+    HOST_CHECK_EQ(cache.in_use, OBJECTS);
+    HOST_CHECK_EQ(cache.high_water, OBJECTS);
+    HOST_CHECK_EQ(cache.frames, (OBJECTS + per_frame - 1) / per_frame);
+    HOST_CHECK_EQ(cache.total, cache.frames * per_frame);
+
+    // Freed objects are reused before any new frame is taken
+    for (int i = 0; i < OBJECTS; i += 2) {
+        slab_free(objs[i]);
+    }
+    HOST_CHECK_EQ(cache.in_use, OBJECTS / 2);
+    int frames = cache.frames;
+    for (int i = 0; i < OBJECTS; i += 2) {
+        objs[i] = slab_alloc(&cache);
+        fill(i, OBJ_SIZE);
+    }
+    HOST_CHECK_EQ(cache.frames, frames);
+    for (int i = 0; i < OBJECTS; i++) {
+        HOST_CHECK(intact(i, OBJ_SIZE));
+        slab_free(objs[i]);
+    }
+    HOST_CHECK_EQ(cache.in_use, 0);
+    HOST_CHECK_EQ(cache.high_water, OBJECTS);
+    slab_free(0);
+
+    // Size classes: each allocation fits and is freed to its own class
+    for (int size = 1; size <= 512; size += 37) {
+        unsigned char *p = slab_kalloc(size);
+
+        HOST_CHECK(p != 0);
+        memset(p, 0xAA, size);
+        slab_free(p);
+    }
+    host_quiet(true);
+    errors = counters[COUNTER_LOG_ERROR];
+    HOST_CHECK(slab_kalloc(513) == 0);
+    HOST_CHECK_EQ(counters[COUNTER_LOG_ERROR], errors + 1);
+
+    // Objects too large for a frame are refused up front and never take
+    // a frame
+    frame_stats(&stats);
+    HOST_CHECK(!slab_cache_init(&big, "big", FRAME_SIZE - 4));
+    HOST_CHECK_EQ(counters[COUNTER_LOG_ERROR], errors + 2);
+    HOST_CHECK(slab_alloc(&big) == 0);
+    HOST_CHECK(slab_alloc(&big) == 0);
+    host_quiet(false);
+    int free_frames = stats.free;
+    frame_stats(&stats);
+    HOST_CHECK_EQ(stats.free, free_frames);
+
+    // The largest object that fits takes a frame each
+    HOST_CHECK(slab_cache_init(&big, "big", FRAME_SIZE - 8));
+    objs[0] = slab_alloc(&big);
+    objs[1] = slab_alloc(&big);
+    HOST_CHECK(objs[0] != 0 && objs[1] != 0);
+    HOST_CHECK_EQ(big.frames, 2);
+    HOST_CHECK_EQ(big.total, 2);
+    memset(objs[0], 0x55, FRAME_SIZE - 8);
+    memset(objs[1], 0x66, FRAME_SIZE - 8);
+    HOST_CHECK_EQ(objs[0][FRAME_SIZE - 9], 0x55);
+    slab_free(objs[0]);
+    slab_free(objs[1]);
+    HOST_CHECK_EQ(big.in_use, 0);
+
+    // The 'm' kernel command logs the frame stats and one line per cache
+    host_quiet(true);
+    errors = counters[COUNTER_LOG_INFO];
+    kernel_command('m');
+    host_quiet(false);
+    HOST_CHECK_EQ(counters[COUNTER_LOG_INFO], errors + 1 + 6 + 2);
+
+    // Running out of frames
+    while (slab_alloc(&big)) {
+    }
+    frame_stats(&stats);
+    HOST_CHECK_EQ(stats.free, 0);
+    HOST_CHECK(slab_alloc(&big) == 0);
+
+    // Arena: aligned bump allocation, refused when full, bulk reset
+    {
+        static char mem[256];
+        arena_t arena;
+        char *a;
+        char *b;
+
+        arena_init(&arena, mem, sizeof(mem));
+        a = arena_alloc(&arena, 5);
+        b = arena_alloc(&arena, 16);
+        HOST_CHECK(a == mem);
+        HOST_CHECK(b == mem + 8);
+        HOST_CHECK(arena_alloc(&arena, 256) == 0);
+        HOST_CHECK(arena_alloc(&arena, -1) == 0);
+        HOST_CHECK(arena_alloc(&arena, 256 - 24) == mem + 24);
+        HOST_CHECK(arena_alloc(&arena, 1) == 0);
+        HOST_CHECK_EQ(arena.high_water, 256);
+        arena_reset(&arena);
+        HOST_CHECK(arena_alloc(&arena, 1) == mem);
+        HOST_CHECK_EQ(arena.high_water, 256);
+    }
+
+    return host_failures != 0;
+}
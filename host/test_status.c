@@ -0,0 +1,65 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: status field widget
+ */
+#include "interrupts.h"
+#include "status.h"
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+#define ROW     (VGA_HEIGHT - 1)
+#define COL     70
+
+// Checks what a console shows at the field's position
+static bool shows(int console, const char *text) {
+    bool same = true;
+
+    vga_console_switch(console);
+    for (int i = 0; text[i]; i++) {
+        same &= (host_vga_screen(ROW, COL + i) & 0xFF) == (unsigned char)text[i];
+    }
+    vga_console_switch(0);
+    return same;
+}
+
+int main(void) {
+    status_field_t field;
+
+    host_quiet(true);
+    vga_init();
+    host_quiet(false);
+
+    // Only the characters that change are written; the field starts blank
+    status_field_init(&field, ROW, COL, 6, VGA_COLOR_RED, VGA_COLOR_WHITE);
+    HOST_CHECK_EQ(status_field_set(&field, "12, 34"), 5);
+    HOST_CHECK_EQ(status_field_printf(&field, "%02d, %02d", 12, 35), 1);
+    HOST_CHECK_EQ(status_field_set(&field, "12, 35"), 0);
+    HOST_CHECK(shows(0, "12, 35"));
+
+    // Updates land on the field's console while output is directed to
+    // another one, and output is directed back afterwards
+    vga_console_select(2);
+    HOST_CHECK_EQ(status_field_set(&field, "99, 99"), 4);
+    HOST_CHECK_EQ(vga_console_output(), 2);
+    vga_console_select(0);
+    HOST_CHECK(shows(0, "99, 99"));
+    HOST_CHECK(shows(2, "      "));
+
+    // After something else draws over the field, invalidating it makes
+    // the next update redraw it whole
+    vga_puts_at(ROW, COL, VGA_COLOR_BLUE, VGA_COLOR_WHITE, "xxxxxx");
+    HOST_CHECK_EQ(status_field_set(&field, "99, 99"), 0);
+    status_field_invalidate(&field);
+    HOST_CHECK_EQ(status_field_set(&field, "99, 99"), 6);
+    HOST_CHECK(shows(0, "99, 99"));
+
+    // Updates leave the interrupt state as they found it
+    interrupts_enable();
+    status_field_printf(&field, "%d", 1);
+    HOST_CHECK(host_interrupts_enabled());
+
+    return host_failures != 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: VGA driver basics
+ */
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+// Cell at a screen position of the console page starting at video memory offset 0
+#define CELL(row, col) (host_vga_memory[(row) * VGA_WIDTH + (col)])
+
+int main(void) {
+    vga_init();
+
+    // Characters land in video memory with the current colors
+    vga_set_rowcol(0, 0);
+    vga_set_bg(VGA_COLOR_BLUE);
+    vga_set_fg(VGA_COLOR_WHITE);
+    vga_puts("hi");
+    HOST_CHECK_EQ(CELL(0, 0), VGA_CHAR(VGA_COLOR_BLUE, VGA_COLOR_WHITE, 'h'));
+    HOST_CHECK_EQ(CELL(0, 1), VGA_CHAR(VGA_COLOR_BLUE, VGA_COLOR_WHITE, 'i'));
+    HOST_CHECK_EQ(vga_get_col(), 2);
+
+    // The cursor location registers follow the position
+    vga_cursor_enable();
+    vga_set_rowcol(3, 7);
+    HOST_CHECK_EQ(host_crtc_register(0x0E) << 8 | host_crtc_register(0x0F), 3 * VGA_WIDTH + 7);
+
+    // Writing past the last row scrolls the screen up one line
+    vga_set_rowcol(VGA_HEIGHT - 1, 0);
+    vga_puts("last\n");
+    HOST_CHECK_EQ(CELL(VGA_HEIGHT - 2, 0) & 0xFF, 'l');
+    HOST_CHECK_EQ(CELL(VGA_HEIGHT - 1, 0) & 0xFF, ' ');
+    HOST_CHECK_EQ(vga_get_row(), VGA_HEIGHT - 1);
+
+    // Recoloring keeps the characters and replaces only one attribute nibble
+    vga_clear_bg(VGA_COLOR_RED);
+    HOST_CHECK_EQ(CELL(VGA_HEIGHT - 2, 0), VGA_CHAR(VGA_COLOR_RED, VGA_COLOR_WHITE, 'l'));
+    vga_clear_fg(VGA_COLOR_GREEN);
+    HOST_CHECK_EQ(CELL(VGA_HEIGHT - 2, 0), VGA_CHAR(VGA_COLOR_RED, VGA_COLOR_GREEN, 'l'));
+
+    // Clearing resets the position and every cell
+    vga_clear();
+    HOST_CHECK_EQ(vga_get_row(), 0);
+    HOST_CHECK_EQ(CELL(VGA_HEIGHT - 2, 0), VGA_CHAR(VGA_COLOR_BLUE, VGA_COLOR_WHITE, ' '));
+
+    return host_failures != 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: virtual consoles
+ */
+#include <string.h>
+
+#include "interrupts.h"
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+// Cells in each console's page of video memory (VGA_CONSOLES is 4)
+#define PAGE_CELLS (0x4000 / 4 / VGA_WIDTH * VGA_WIDTH)
+
+static int start_address(void) {
+    return host_crtc_register(0x0C) << 8 | host_crtc_register(0x0D);
+}
+
+static int cursor(void) {
+    return host_crtc_register(0x0E) << 8 | host_crtc_register(0x0F);
+}
+
+// Checks that a screen row starts with the given text (once flushed)
+static bool row_is(int row, const char *text) {
+    vga_flush();
+    for (int col = 0; text[col]; col++) {
+        if ((host_vga_screen(row, col) & 0xFF) != (unsigned char)text[col]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Switches between consoles and checks that each keeps its own screen,
+ * position and colors
+ */
+static void check_consoles(void) {
+    vga_init();
+    vga_cursor_enable();
+    vga_console_switch(0);
+
+    vga_puts("console zero\n");
+    vga_set_fg(VGA_COLOR_YELLOW);
+
+    // Console 1 is shown from its own page, blank, with its own position
+    vga_console_switch(1);
+    HOST_CHECK_EQ(vga_console_active(), 1);
+    HOST_CHECK_EQ(start_address(), PAGE_CELLS);
+    HOST_CHECK(row_is(0, "    "));
+    HOST_CHECK_EQ(vga_get_row(), 0);
+    HOST_CHECK_EQ(vga_get_fg(), VGA_COLOR_LIGHT_GREY);
+    HOST_CHECK_EQ(cursor(), PAGE_CELLS);
+    vga_puts("console one");
+    HOST_CHECK(row_is(0, "console one"));
+
+    // Output directed to a console in the background does not show
+    int prev = vga_console_select(2);
+    HOST_CHECK_EQ(prev, 1);
+    for (int i = 0; i < 30; i++) {
+        vga_printf("background %d\n", i);
+    }
+    vga_console_select(prev);
+    HOST_CHECK(row_is(0, "console one"));
+
+    // Switching back restores console 0's screen, position and colors
+    vga_console_switch(0);
+    HOST_CHECK_EQ(start_address() % PAGE_CELLS, start_address());
+    HOST_CHECK(row_is(0, "console zero"));
+    HOST_CHECK_EQ(vga_get_row(), 1);
+    HOST_CHECK_EQ(vga_get_fg(), VGA_COLOR_YELLOW);
+    HOST_CHECK_EQ(cursor(), start_address() + VGA_WIDTH);
+
+    // Console 2 shows what was written while it was hidden, scrolled
+    vga_console_switch(2);
+    HOST_CHECK(row_is(VGA_HEIGHT - 2, "background 29"));
+    HOST_CHECK(row_is(0, "background 6"));
+
+    // And console 1 what it had
+    vga_console_switch(1);
+    HOST_CHECK(row_is(0, "console one"));
+    vga_console_switch(0);
+
+    // Invalid console numbers are ignored
+    vga_console_switch(4);
+    vga_console_switch(-1);
+    HOST_CHECK_EQ(vga_console_active(), 0);
+    HOST_CHECK_EQ(vga_console_select(9), 0);
+}
+
+int main(void) {
+    check_consoles();
+
+    // Same behavior with the shadow buffer and with ring scrolling
+    vga_shadow_enable(false);
+    check_consoles();
+    vga_shadow_disable();
+
+    vga_ring_enable();
+    check_consoles();
+
+    // A switch only copies the cells that changed while hidden: a hidden
+    // console with one changed line costs about one line of writes
+    vga_console_select(3);
+    vga_console_switch(3);
+    vga_console_switch(0);
+    vga_console_select(3);
+    vga_puts_at(5, 0, VGA_COLOR_BLACK, VGA_COLOR_WHITE, "changed while hidden");
+    vga_console_select(0);
+    host_vga_watch(true);
+    vga_console_switch(3);
+    host_vga_watch(false);
+    HOST_CHECK(row_is(5, "changed while hidden"));
+
+    // Leaving console 0 without the shadow reads its visible page once
+    HOST_CHECK(host_vga_writes() <= VGA_WIDTH);
+    HOST_CHECK(host_vga_reads() <= VGA_HEIGHT * VGA_WIDTH);
+
+    // Every call leaves the interrupt state as it found it, including the
+    // ones that return early
+    for (int enabled = 0; enabled < 2; enabled++) {
+        if (enabled) {
+            interrupts_enable();
+        } else {
+            interrupts_disable();
+        }
+        vga_console_switch(1);
+        vga_console_switch(1);
+        vga_console_switch(7);
+        vga_console_select(2);
+        vga_printf("%d\n", enabled);
+        vga_puts_at(VGA_HEIGHT, 0, VGA_COLOR_BLACK, VGA_COLOR_WHITE, "off screen");
+        vga_fill_rect(-5, 0, 2, 4, VGA_COLOR_BLACK, VGA_COLOR_WHITE, ' ');
+        vga_recolor_rect(0, 0, 1, 1, -1, -1);
+        vga_scroll_region(5, 2);
+        vga_scrollback_view(0);
+        vga_scrollback_view(3);
+        vga_console_select(0);
+        vga_console_switch(0);
+        vga_cursor_sync();
+        vga_flush();
+        HOST_CHECK_EQ(host_interrupts_enabled(), enabled);
+    }
+
+    return host_failures != 0;
+}
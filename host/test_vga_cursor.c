@@ -0,0 +1,73 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: deferred and coalesced hardware cursor updates
+ */
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+// Cursor location as last written to the CRTC
+static int cursor(void) {
+    return host_crtc_register(0x0E) << 8 | host_crtc_register(0x0F);
+}
+
+int main(void) {
+    vga_init();
+    vga_cursor_enable();
+    vga_set_rowcol(2, 0);
+    HOST_CHECK_EQ(cursor(), 2 * VGA_WIDTH);
+
+    // Moving to the same position again does no port I/O
+    host_port_reset();
+    vga_set_rowcol(2, 0);
+    HOST_CHECK_EQ(host_port_total(), 0);
+
+    // While deferred, characters only move the cursor in software
+    vga_cursor_defer(true);
+    host_port_reset();
+    for (int i = 0; i < 10; i++) {
+        vga_putc('a' + i);
+    }
+    HOST_CHECK_EQ(host_port_total(), 0);
+    HOST_CHECK_EQ(cursor(), 2 * VGA_WIDTH);
+
+    // An explicit sync writes the position once: two registers, two ports each
+    vga_cursor_sync();
+    HOST_CHECK_EQ(host_port_total(), 4);
+    HOST_CHECK_EQ(cursor(), 2 * VGA_WIDTH + 10);
+
+    // vga_puts and vga_printf sync once at the end of the call
+    host_port_reset();
+    vga_puts("0123456789012345678901234567890123456789\n");
+    HOST_CHECK_EQ(host_port_total(), 4);
+    HOST_CHECK_EQ(cursor(), 3 * VGA_WIDTH);
+
+    host_port_reset();
+    vga_printf("%d %s %x", 42, "and", 0x42);
+    HOST_CHECK_EQ(host_port_total(), 4);
+    HOST_CHECK_EQ(cursor(), 3 * VGA_WIDTH + 9);
+
+    // Syncing an unchanged position is free
+    host_port_reset();
+    vga_cursor_sync();
+    HOST_CHECK_EQ(host_port_total(), 0);
+
+    // Turning deferral off syncs right away
+    vga_putc('!');
+    vga_cursor_defer(false);
+    HOST_CHECK_EQ(cursor(), 3 * VGA_WIDTH + 10);
+
+    // With the cursor disabled nothing is written
+    vga_cursor_disable();
+    host_port_reset();
+    vga_puts("hidden");
+    HOST_CHECK_EQ(host_port_total(), 0);
+
+    // Enabling it again puts it at the current position
+    vga_cursor_enable();
+    HOST_CHECK_EQ(cursor(), 3 * VGA_WIDTH + 16);
+
+    return host_failures != 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: VGA fill and recolor kernels
+ *
+ * Random rectangles (including ones hanging off the screen, at every
+ * alignment and width) are filled and recolored, and the screen is checked
+ * against a cell-at-a-time model. The test is also built against a copy of
+ * vga.c compiled without SSE2 (test_vga_fill_scalar), so both the SSE2 and
+ * the 32-bit word paths are covered.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+#define ROUNDS 20000
+
+static unsigned short model[VGA_HEIGHT][VGA_WIDTH];
+
+static void model_rect(int row, int col, int height, int width,
+                       unsigned short mask, unsigned short bits) {
+    for (int r = row; r < row + height; r++) {
+        for (int c = col; c < col + width; c++) {
+            if (r >= 0 && r < VGA_HEIGHT && c >= 0 && c < VGA_WIDTH) {
+                model[r][c] = (model[r][c] & ~mask) | (bits & mask);
+            }
+        }
+    }
+}
+
+static void check_screen(void) {
+    HOST_CHECK(memcmp(model, host_vga_memory, sizeof(model)) == 0);
+}
+
+int main(void) {
+    srand(159);
+    vga_init();
+
+    for (int r = 0; r < VGA_HEIGHT; r++) {
+        for (int c = 0; c < VGA_WIDTH; c++) {
+            model[r][c] = host_vga_memory[r * VGA_WIDTH + c];
+        }
+    }
+
+    for (int i = 0; i < ROUNDS && host_failures == 0; i++) {
+        int row = rand() % (VGA_HEIGHT + 4) - 2;
+        int col = rand() % (VGA_WIDTH + 8) - 4;
+        int height = rand() % 6;
+        int width = (i % 8 == 0) ? VGA_WIDTH : rand() % (VGA_WIDTH + 4);
+        int bg = rand() % 16;
+        int fg = rand() % 16;
+
+        if (rand() % 2) {
+            unsigned char c = 'A' + rand() % 26;
+
+            vga_fill_rect(row, col, height, width, bg, fg, c);
+            model_rect(row, col, height, width, 0xFFFF, VGA_CHAR(bg, fg, c));
+        } else {
+            // -1 keeps one of the colors
+            switch (rand() % 3) {
+                case 0: bg = -1; break;
+                case 1: fg = -1; break;
+            }
+            vga_recolor_rect(row, col, height, width, bg, fg);
+            model_rect(row, col, height, width,
+                       (bg >= 0 ? 0xF000 : 0) | (fg >= 0 ? 0x0F00 : 0),
+                       VGA_CHAR(bg, fg, 0));
+        }
+        check_screen();
+    }
+
+    // Whole-screen recolors change only their attribute nibble
+    vga_clear_bg(VGA_COLOR_BLUE);
+    model_rect(0, 0, VGA_HEIGHT, VGA_WIDTH, 0xF000, VGA_CHAR(VGA_COLOR_BLUE, 0, 0));
+    check_screen();
+    vga_clear_fg(VGA_COLOR_YELLOW);
+    model_rect(0, 0, VGA_HEIGHT, VGA_WIDTH, 0x0F00, VGA_CHAR(0, VGA_COLOR_YELLOW, 0));
+    check_screen();
+
+    // Clearing fills with spaces in the current colors
+    vga_set_bg(VGA_COLOR_RED);
+    vga_set_fg(VGA_COLOR_WHITE);
+    vga_clear();
+    model_rect(0, 0, VGA_HEIGHT, VGA_WIDTH, 0xFFFF, VGA_CHAR(VGA_COLOR_RED, VGA_COLOR_WHITE, ' '));
+    check_screen();
+
+    return host_failures != 0;
+}
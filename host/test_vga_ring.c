@@ -0,0 +1,130 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: ring scrolling through the CRTC start address
+ *
+ * Scroll-heavy output is run with and without the ring (and with the ring
+ * over the shadow buffer); the displayed screen must be identical, while
+ * the ring moves the start address instead of copying lines.
+ */
+#include <string.h>
+
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+typedef struct snapshot {
+    unsigned short cells[VGA_HEIGHT][VGA_WIDTH];
+    int cursor;         // cursor location relative to the start address
+} snapshot_t;
+
+static int start_address(void) {
+    return host_crtc_register(0x0C) << 8 | host_crtc_register(0x0D);
+}
+
+static int cursor(void) {
+    return host_crtc_register(0x0E) << 8 | host_crtc_register(0x0F);
+}
+
+/**
+ * Prints enough lines to wrap the ring within the console's page several
+ * times, with some output that is not a plain full-screen scroll
+ */
+static void workload(void) {
+    vga_init();
+    vga_cursor_enable();
+
+    for (int i = 0; i < 150; i++) {
+        vga_printf("%3d: %s\n", i, "scrolling through the ring");
+        if (i % 37 == 0) {
+            vga_putc_at(0, 70, VGA_COLOR_RED, VGA_COLOR_WHITE, '@');
+        }
+    }
+    vga_fill_rect(10, 10, 3, 30, VGA_COLOR_BLUE, VGA_COLOR_YELLOW, '#');
+
+    // A pinned status line: the region scroll cannot move the window
+    vga_scroll_region(0, VGA_HEIGHT - 2);
+    vga_puts_at(VGA_HEIGHT - 1, 0, VGA_COLOR_GREEN, VGA_COLOR_BLACK, "status");
+    for (int i = 0; i < 30; i++) {
+        vga_printf("region %d\n", i);
+    }
+    vga_scroll_region(0, VGA_HEIGHT - 1);
+    for (int i = 0; i < 30; i++) {
+        vga_printf("full again %d\n", i);
+    }
+    vga_puts("end");
+}
+
+static void snapshot(snapshot_t *s) {
+    vga_flush();
+    vga_cursor_sync();
+    for (int row = 0; row < VGA_HEIGHT; row++) {
+        for (int col = 0; col < VGA_WIDTH; col++) {
+            s->cells[row][col] = host_vga_screen(row, col);
+        }
+    }
+    s->cursor = cursor() - start_address();
+}
+
+static void check_same(const snapshot_t *a, const snapshot_t *b) {
+    HOST_CHECK(memcmp(a->cells, b->cells, sizeof(a->cells)) == 0);
+    HOST_CHECK_EQ(a->cursor, b->cursor);
+}
+
+int main(void) {
+    static snapshot_t direct, ring, ring_shadow;
+
+    workload();
+    snapshot(&direct);
+    HOST_CHECK_EQ(start_address(), 0);
+
+    memset(host_vga_memory, 0xEE, sizeof(host_vga_memory));
+    vga_ring_enable();
+    HOST_CHECK(vga_ring_enabled());
+    workload();
+    snapshot(&ring);
+    check_same(&direct, &ring);
+
+    // The window stays inside console 0's page
+    HOST_CHECK(start_address() + VGA_HEIGHT * VGA_WIDTH <= 0x4000 / 4);
+
+    // A full-screen scroll moves the window and clears one line. Video
+    // memory is only read for the line saved to scrollback, and only the
+    // start address is written: the cursor stays at the same address
+    vga_set_rowcol(VGA_HEIGHT - 1, 0);
+    int before = start_address();
+    host_port_reset();
+    host_vga_watch(true);
+    vga_scroll();
+    host_vga_watch(false);
+    if (start_address() == before + VGA_WIDTH) {
+        HOST_CHECK(host_vga_reads() <= VGA_WIDTH);
+        HOST_CHECK(host_vga_writes() <= VGA_WIDTH);
+        HOST_CHECK_EQ(host_port_total(), 4);
+    } else {
+        // The window wrapped back to the start of the page
+        HOST_CHECK_EQ(start_address(), 0);
+    }
+
+    // Disabling the ring moves the screen back to the start of the page
+    snapshot(&ring);
+    vga_ring_disable();
+    HOST_CHECK_EQ(start_address(), 0);
+    snapshot(&direct);
+    check_same(&ring, &direct);
+
+    // The ring over the shadow: scrolls are applied at the flush
+    memset(host_vga_memory, 0xEE, sizeof(host_vga_memory));
+    vga_ring_enable();
+    vga_shadow_enable(false);
+    workload();
+    snapshot(&ring_shadow);
+    vga_shadow_disable();
+    vga_ring_disable();
+    workload();
+    snapshot(&direct);
+    check_same(&direct, &ring_shadow);
+
+    return host_failures != 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: scrollback history
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+// Lines of history kept per console (VGA_SCROLLBACK_LINES is 256)
+#define HISTORY 256
+
+static int next_line = 0;
+
+static void print_lines(int count) {
+    for (int i = 0; i < count; i++) {
+        vga_printf("line %d\n", next_line++);
+    }
+}
+
+// The line number shown on a row, or -1 if the row is not a printed line
+static int row_line(int row) {
+    char text[16];
+
+    vga_flush();
+    for (int col = 0; col < (int)sizeof(text) - 1; col++) {
+        text[col] = host_vga_screen(row, col) & 0xFF;
+    }
+    text[sizeof(text) - 1] = '\0';
+    return strncmp(text, "line ", 5) == 0 ? atoi(text + 5) : -1;
+}
+
+static bool row_is(int row, const char *text) {
+    vga_flush();
+    for (int col = 0; text[col]; col++) {
+        if ((host_vga_screen(row, col) & 0xFF) != (unsigned char)text[col]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Scrolls back and forth with the whole screen scrolling
+ */
+static void check_history(void) {
+    int live;
+
+    // 60 lines on a 25-line screen: 36 have scrolled off into the ring
+    print_lines(60);
+    live = row_line(0);
+    HOST_CHECK_EQ(live, 36);
+
+    // Each line back shows one more line of history at the top
+    vga_scrollback_view(1);
+    HOST_CHECK_EQ(vga_scrollback_offset(), 1);
+    HOST_CHECK_EQ(row_line(0), 35);
+    HOST_CHECK_EQ(row_line(1), 36);
+    vga_scrollback_view(10);
+    HOST_CHECK_EQ(row_line(0), 25);
+
+    // The offset is clamped to the history there is, and to zero
+    vga_scrollback_view(1000);
+    HOST_CHECK_EQ(vga_scrollback_offset(), 36);
+    HOST_CHECK_EQ(row_line(0), 0);
+    vga_scrollback_view(-1000);
+    HOST_CHECK_EQ(vga_scrollback_offset(), 0);
+    HOST_CHECK_EQ(row_line(0), 36);
+    HOST_CHECK_EQ(row_line(VGA_HEIGHT - 2), 59);
+
+    // Output while scrolled back returns to the live screen first
+    vga_scrollback_view(5);
+    vga_puts("more");
+    HOST_CHECK_EQ(vga_scrollback_offset(), 0);
+    HOST_CHECK_EQ(row_line(0), 36);
+    HOST_CHECK(row_is(VGA_HEIGHT - 1, "more"));
+    vga_puts("\n");
+
+    // The ring wraps: only the newest lines are kept
+    print_lines(400);
+    live = row_line(0);
+    vga_scrollback_view(100000);
+    HOST_CHECK_EQ(vga_scrollback_offset(), HISTORY);
+    HOST_CHECK_EQ(row_line(0), live - HISTORY);
+    vga_scrollback_view(-(HISTORY - 1));
+    HOST_CHECK_EQ(row_line(0), live - 1);
+    vga_scrollback_view(-1);
+    HOST_CHECK_EQ(row_line(0), live);
+}
+
+/**
+ * Scrolls back with lines pinned below the scroll region
+ */
+static void check_region(void) {
+    int live;
+
+    vga_scroll_region(0, VGA_HEIGHT - 3);
+    vga_puts_at(VGA_HEIGHT - 2, 0, VGA_COLOR_CYAN, VGA_COLOR_WHITE, "pinned one");
+    vga_puts_at(VGA_HEIGHT - 1, 0, VGA_COLOR_BLUE, VGA_COLOR_WHITE, "pinned two");
+    print_lines(60);
+    live = row_line(0);
+
+    // Only the region is repainted; the pinned lines stay
+    vga_scrollback_view(VGA_HEIGHT - 1);
+    HOST_CHECK_EQ(row_line(0), live - (VGA_HEIGHT - 1));
+    HOST_CHECK_EQ(row_line(VGA_HEIGHT - 3), live - 2);
+    HOST_CHECK(row_is(VGA_HEIGHT - 2, "pinned one"));
+    HOST_CHECK(row_is(VGA_HEIGHT - 1, "pinned two"));
+
+    // Writing to a pinned line while scrolled back returns to live first
+    vga_puts_at(VGA_HEIGHT - 1, 0, VGA_COLOR_BLUE, VGA_COLOR_WHITE, "pinned TWO");
+    HOST_CHECK_EQ(vga_scrollback_offset(), 0);
+    HOST_CHECK_EQ(row_line(0), live);
+    HOST_CHECK(row_is(VGA_HEIGHT - 2, "pinned one"));
+    HOST_CHECK(row_is(VGA_HEIGHT - 1, "pinned TWO"));
+
+    // A region that does not start at the top keeps no history
+    vga_scroll_region(2, VGA_HEIGHT - 3);
+    vga_scrollback_view(5);
+    HOST_CHECK_EQ(vga_scrollback_offset(), 0);
+
+    vga_scroll_region(0, VGA_HEIGHT - 1);
+}
+
+int main(void) {
+    host_quiet(true);
+    vga_init();
+    host_quiet(false);
+
+    check_history();
+    check_region();
+
+    // Through the shadow buffer and with ring scrolling, the same
+    vga_shadow_enable(false);
+    check_region();
+    vga_shadow_disable();
+
+    vga_ring_enable();
+    check_region();
+    vga_ring_disable();
+
+    return host_failures != 0;
+}
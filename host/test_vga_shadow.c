@@ -0,0 +1,107 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: VGA shadow buffer
+ *
+ * The same sequence of driver calls is run with and without the shadow
+ * buffer; once flushed, the screen and cursor must be identical.
+ */
+#include <string.h>
+
+#include "vga.h"
+#include "vga_ext.h"
+#include "host.h"
+
+typedef struct snapshot {
+    unsigned short cells[VGA_HEIGHT][VGA_WIDTH];
+    int row;
+    int col;
+    int cursor;
+} snapshot_t;
+
+/**
+ * Runs a mix of output calls that touch every dirty-span path
+ */
+static void workload(void) {
+    vga_init();
+    vga_cursor_enable();
+    vga_set_bg(VGA_COLOR_BLACK);
+    vga_set_fg(VGA_COLOR_LIGHT_GREY);
+
+    for (int i = 0; i < 40; i++) {
+        vga_printf("line %d: %s\n", i, "the quick brown fox jumps over the lazy dog");
+    }
+    vga_putc_at(2, 5, VGA_COLOR_RED, VGA_COLOR_WHITE, '*');
+    vga_puts_at(4, 70, VGA_COLOR_BLUE, VGA_COLOR_YELLOW, "edge of the row");
+    vga_fill_rect(6, 10, 4, 20, VGA_COLOR_BLUE, VGA_COLOR_YELLOW, '#');
+    vga_recolor_rect(7, 15, 2, 10, VGA_COLOR_GREEN, -1);
+    vga_printf("tab\there\rback\bspace\n");
+    vga_set_rowcol(10, 40);
+    vga_puts("in the middle");
+    vga_clear_fg(VGA_COLOR_CYAN);
+    vga_set_rowcol(VGA_HEIGHT - 1, 75);
+    vga_puts("wraps and scrolls");
+    vga_clear_bg(VGA_COLOR_MAGENTA);
+    vga_scroll();
+    vga_puts("done");
+}
+
+static void snapshot(snapshot_t *s) {
+    vga_flush();
+    vga_cursor_sync();
+    for (int row = 0; row < VGA_HEIGHT; row++) {
+        for (int col = 0; col < VGA_WIDTH; col++) {
+            s->cells[row][col] = host_vga_screen(row, col);
+        }
+    }
+    s->row = vga_get_row();
+    s->col = vga_get_col();
+    s->cursor = host_crtc_register(0x0E) << 8 | host_crtc_register(0x0F);
+}
+
+static void check_same(const snapshot_t *a, const snapshot_t *b) {
+    HOST_CHECK(memcmp(a->cells, b->cells, sizeof(a->cells)) == 0);
+    HOST_CHECK_EQ(a->row, b->row);
+    HOST_CHECK_EQ(a->col, b->col);
+    HOST_CHECK_EQ(a->cursor, b->cursor);
+}
+
+int main(void) {
+    static snapshot_t direct, shadow, autoflush;
+
+    // Garbage in video memory shows up if a changed span is not flushed
+    memset(host_vga_memory, 0xEE, sizeof(host_vga_memory));
+    workload();
+    snapshot(&direct);
+
+    memset(host_vga_memory, 0xEE, sizeof(host_vga_memory));
+    vga_shadow_enable(false);
+    workload();
+
+    // Nothing reaches video memory until the flush
+    HOST_CHECK_EQ(host_vga_screen(0, 0), 0xEEEE);
+    snapshot(&shadow);
+    check_same(&direct, &shadow);
+
+    memset(host_vga_memory, 0xEE, sizeof(host_vga_memory));
+    vga_shadow_enable(true);
+    workload();
+    snapshot(&autoflush);
+    check_same(&direct, &autoflush);
+
+    // A flush with nothing changed writes nothing
+    host_vga_watch(true);
+    vga_flush();
+    host_vga_watch(false);
+    HOST_CHECK_EQ(host_vga_writes(), 0);
+    HOST_CHECK_EQ(host_vga_reads(), 0);
+
+    // Disabling the shadow leaves the screen as it was
+    vga_shadow_disable();
+    HOST_CHECK(!vga_shadow_enabled());
+    vga_puts("x");
+    HOST_CHECK_EQ(host_vga_screen(vga_get_row(), vga_get_col() - 1) & 0xFF, 'x');
+
+    return host_failures != 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tests: deferred work queue
+ *
+ * Items are run with workq_run() directly, as the worker task would.
+ */
+#include "counters.h"
+#include "interrupts.h"
+#include "trace.h"
+#include "workq.h"
+#include "host.h"
+
+#define SPIN_CYCLES 1000000ULL
+
+static unsigned int ran[4 * WORKQ_SIZE];
+static int ran_count;
+static unsigned long long ran_tsc;
+
+static void record(unsigned int arg) {
+    ran[ran_count++] = arg;
+    ran_tsc = trace_rdtsc();
+}
+
+int main(void) {
+    workq_stats_t before;
+    workq_stats_t stats;
+    unsigned int next = 0;
+    bool ordered = true;
+
+    // FIFO order, over enough rounds for the indices to wrap around the
+    // slots several times
+    for (int round = 0; round < 10; round++) {
+        int count = 1 + round * 11 % WORKQ_SIZE;
+
+        ran_count = 0;
+        for (int i = 0; i < count; i++) {
+            HOST_CHECK(workq_queue(record, next + i));
+        }
+        HOST_CHECK_EQ(workq_run(0), count);
+        for (int i = 0; i < count; i++) {
+            ordered &= (ran[i] == next + i);
+        }
+        next += count;
+    }
+    HOST_CHECK(ordered);
+    HOST_CHECK_EQ(workq_run(0), 0);
+
+    // A full queue drops new items and counts them; the ones already
+    // queued are kept
+    workq_stats(&before);
+    unsigned int drops = counters[COUNTER_WORKQ_DROPS];
+    for (int i = 0; i < WORKQ_SIZE; i++) {
+        HOST_CHECK(workq_queue(record, i));
+    }
+    HOST_CHECK(!workq_queue(record, 1000));
+    HOST_CHECK(!workq_queue(record, 1001));
+    workq_stats(&stats);
+    HOST_CHECK_EQ(stats.dropped - before.dropped, 2);
+    HOST_CHECK_EQ(stats.queued - before.queued, WORKQ_SIZE);
+    HOST_CHECK_EQ(stats.max_depth, WORKQ_SIZE);
+    HOST_CHECK_EQ(counters[COUNTER_WORKQ_DROPS] - drops, 2);
+
+    // Batches: at most max items per call, the rest left for the next
+    ran_count = 0;
+    HOST_CHECK_EQ(workq_run(WORKQ_BATCH), WORKQ_BATCH);
+    HOST_CHECK_EQ(ran_count, WORKQ_BATCH);
+    HOST_CHECK_EQ(ran[WORKQ_BATCH - 1], WORKQ_BATCH - 1);
+    HOST_CHECK_EQ(workq_run(WORKQ_BATCH), WORKQ_BATCH);
+    HOST_CHECK_EQ(workq_run(0), WORKQ_SIZE - 2 * WORKQ_BATCH);
+    HOST_CHECK_EQ(ran[WORKQ_SIZE - 1], WORKQ_SIZE - 1);
+
+    // Room again once the queue has drained
+    HOST_CHECK(workq_queue(record, 7));
+    HOST_CHECK_EQ(workq_run(0), 1);
+
+    // Latency: the time from queueing to running, its maximum and total
+    workq_stats(&before);
+    unsigned long long queued = trace_rdtsc();
+    HOST_CHECK(workq_queue(record, 0));
+    while (trace_rdtsc() - queued < SPIN_CYCLES) {
+    }
+    HOST_CHECK_EQ(workq_run(0), 1);
+    workq_stats(&stats);
+    HOST_CHECK_EQ(stats.run - before.run, 1);
+    HOST_CHECK(stats.max_latency >= SPIN_CYCLES);
+    HOST_CHECK(stats.max_latency <= ran_tsc - queued);
+    HOST_CHECK(stats.total_latency - before.total_latency >= SPIN_CYCLES);
+    HOST_CHECK(stats.total_latency - before.total_latency <= ran_tsc - queued);
+
+    // A short wait does not lower the maximum
+    HOST_CHECK(workq_queue(record, 0));
+    HOST_CHECK_EQ(workq_run(0), 1);
+    workq_stats(&before);
+    HOST_CHECK_EQ(before.max_latency, stats.max_latency);
+
+    // Queueing leaves the interrupt state as it found it
+    interrupts_enable();
+    workq_queue(record, 0);
+    HOST_CHECK(host_interrupts_enabled());
+    workq_run(0);
+    HOST_CHECK(host_interrupts_enabled());
+
+    return host_failures != 0;
+}
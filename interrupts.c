@@ -0,0 +1,216 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Interrupt Functions
+ */
+#include <spede/machine/proc_reg.h>     // for get_idt_base(), get_cs()
+#include <spede/machine/seg.h>          // for fill_gate(), ACC_INTR_GATE
+
+#include "counters.h"
+#include "interrupts.h"
+#include "io.h"
+#include "kernel.h"
+#include "kernel_log.h"
+#include "sched.h"
+#include "trace.h"
+
+// PIC ports
+#define PIC1_CMD        0x20
+#define PIC1_DATA       0x21
+#define PIC2_CMD        0xA0
+#define PIC2_DATA       0xA1
+
+// PIC specific end-of-interrupt command (OR'ed with the IRQ line)
+#define PIC_EOI_SPECIFIC 0x60
+
+// IRQ line on the primary PIC that the secondary PIC is cascaded through
+#define PIC_CASCADE_IRQ 2
+
+/**
+ * Interrupt entry stubs
+ *
+ * Each IRQ has a small stub that pushes its IRQ number and jumps to a
+ * common path. The common path saves the general purpose registers to
+ * build a trapframe_t, passes it to interrupts_irq_handler(), and resumes
+ * from the trapframe that is returned. isr_yield does the same for the
+ * software interrupt used by sched_yield().
+ */
+extern void (*isr_irq_table[IRQ_COUNT])(void);
+extern void isr_yield(void);
+
+#define INTERRUPTS_STR(x) #x
+#define INTERRUPTS_XSTR(x) INTERRUPTS_STR(x)
+
+__asm__(
+    ".text\n"
+    ".irp irq, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15\n"
+    "isr_irq\\irq:\n"
+    "    pushl $\\irq\n"
+    "    jmp isr_irq_common\n"
+    ".endr\n"
+    "isr_yield:\n"
+    "    pushl $" INTERRUPTS_XSTR(IRQ_YIELD) "\n"
+    "    jmp isr_irq_common\n"
+    "isr_irq_common:\n"
+    "    pusha\n"
+    "    cld\n"
+    "    pushl %esp\n"
+    "    call interrupts_irq_handler\n"
+    "    movl %eax, %esp\n"
+    "    popa\n"
+    "    addl $4, %esp\n"
+    "    iret\n"
+    ".data\n"
+    ".align 4\n"
+    "isr_irq_table:\n"
+    ".irp irq, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15\n"
+    "    .long isr_irq\\irq\n"
+    ".endr\n"
+    ".text\n"
+);
+
+// Registered handler for each IRQ
+static irq_handler_t irq_handlers[IRQ_COUNT];
+
+/**
+ * Initializes the interrupt descriptor table entries for all IRQs
+ *
+ * All IRQ lines are masked; drivers unmask their line when they register
+ * a handler. Interrupts stay disabled until interrupts_enable() is called.
+ */
+void interrupts_init(void) {
+    struct i386_gate *idt = get_idt_base();
+
+    kernel_log_info("Initializing interrupts");
+
+    outportb(PIC1_DATA, 0xFF);
+    outportb(PIC2_DATA, 0xFF);
+
+    for (int irq = 0; irq < IRQ_COUNT; irq++) {
+        irq_handlers[irq] = 0;
+        fill_gate(&idt[IRQ_BASE + irq], (int)isr_irq_table[irq], get_cs(), ACC_INTR_GATE, 0);
+    }
+    fill_gate(&idt[IRQ_BASE + IRQ_YIELD], (int)isr_yield, get_cs(), ACC_INTR_GATE, 0);
+
+    // The secondary PIC can only raise interrupts through the cascade line
+    pic_irq_enable(PIC_CASCADE_IRQ);
+}
+
+/**
+ * Enables interrupts on the CPU
+ */
+void interrupts_enable(void) {
+    __asm__ __volatile__("sti" ::: "memory");
+}
+
+/**
+ * Disables interrupts on the CPU
+ */
+void interrupts_disable(void) {
+    __asm__ __volatile__("cli" ::: "memory");
+}
+
+/**
+ * Disables interrupts and returns the previous CPU flags so the previous
+ * state can be put back with interrupts_restore()
+ *
+ * @return the CPU flags before interrupts were disabled
+ */
+unsigned int interrupts_save(void) {
+    unsigned int flags;
+
+    __asm__ __volatile__("pushfl; popl %0; cli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+/**
+ * Restores the CPU flags (and so the interrupt enable state) returned by
+ * interrupts_save()
+ *
+ * @param flags - the CPU flags to restore
+ */
+void interrupts_restore(unsigned int flags) {
+    __asm__ __volatile__("pushl %0; popfl" :: "r"(flags) : "memory", "cc");
+}
+
+/**
+ * Registers the handler for an IRQ and unmasks the IRQ line
+ *
+ * @param irq - IRQ line (0 to IRQ_COUNT-1)
+ * @param handler - function called each time the IRQ fires
+ */
+void interrupts_irq_register(int irq, irq_handler_t handler) {
+    if (irq < 0 || irq >= IRQ_COUNT) {
+        kernel_log_error("interrupts: invalid irq %d", irq);
+        return;
+    }
+
+    irq_handlers[irq] = handler;
+    pic_irq_enable(irq);
+}
+
+/**
+ * Common interrupt handler, called from the entry stubs with interrupts
+ * disabled
+ *
+ * @param frame - register state of the interrupted code
+ * @return the register state to resume
+ */
+trapframe_t *interrupts_irq_handler(trapframe_t *frame) {
+    int irq = frame->irq;
+
+    // A yield has no handler and was not raised through the PIC
+    if (irq == IRQ_YIELD) {
+        sched_preempt();
+        return sched_irq_exit(frame);
+    }
+
+    TRACE(TRACE_IRQ, irq, frame->eip, 0, 0);
+    COUNTER_INC(COUNTER_IRQS);
+
+    if (irq_handlers[irq]) {
+        irq_handlers[irq](frame);
+    } else {
+        kernel_log_warn("interrupts: unhandled irq %d", irq);
+    }
+
+    pic_irq_eoi(irq);
+
+    // The handler may have made another task due to run
+    return sched_irq_exit(frame);
+}
+
+/**
+ * Unmasks an IRQ line on the PIC
+ * @param irq - IRQ line (0 to IRQ_COUNT-1)
+ */
+void pic_irq_enable(int irq) {
+    unsigned short port = (irq < 8) ? PIC1_DATA : PIC2_DATA;
+
+    outportb(port, inportb(port) & ~(1 << (irq & 7)));
+}
+
+/**
+ * Masks an IRQ line on the PIC
+ * @param irq - IRQ line (0 to IRQ_COUNT-1)
+ */
+void pic_irq_disable(int irq) {
+    unsigned short port = (irq < 8) ? PIC1_DATA : PIC2_DATA;
+
+    outportb(port, inportb(port) | (1 << (irq & 7)));
+}
+
+/**
+ * Acknowledges an IRQ so the PIC can deliver it again
+ * @param irq - IRQ line (0 to IRQ_COUNT-1)
+ */
+void pic_irq_eoi(int irq) {
+    if (irq >= 8) {
+        outportb(PIC2_CMD, PIC_EOI_SPECIFIC | (irq & 7));
+        COUNTER_INC(COUNTER_PIC_PORT_WRITES);
+        irq = PIC_CASCADE_IRQ;
+    }
+    outportb(PIC1_CMD, PIC_EOI_SPECIFIC | irq);
+    COUNTER_INC(COUNTER_PIC_PORT_WRITES);
+}
@@ -0,0 +1,59 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Interrupt Functions
+ */
+#ifndef INTERRUPTS_H
+#define INTERRUPTS_H
+
+// Interrupt vector of IRQ 0 (the PIC is remapped past the CPU exceptions)
+#define IRQ_BASE        0x20
+#define IRQ_COUNT       16
+
+// Hardware IRQ lines
+#define IRQ_TIMER       0
+#define IRQ_KEYBOARD    1
+#define IRQ_COM1        4
+
+// Software interrupt raised by sched_yield(), dispatched as if it were an
+// IRQ past the hardware lines (vector IRQ_BASE + IRQ_YIELD)
+#define IRQ_YIELD       IRQ_COUNT
+
+/**
+ * Register state saved on the stack when an interrupt is taken
+ *
+ * The general purpose registers are in the order pushed by pusha, the
+ * IRQ number is pushed by the entry stub, and eip/cs/eflags are pushed by
+ * the CPU.
+ */
+typedef struct trapframe {
+    unsigned int edi;
+    unsigned int esi;
+    unsigned int ebp;
+    unsigned int esp;
+    unsigned int ebx;
+    unsigned int edx;
+    unsigned int ecx;
+    unsigned int eax;
+    unsigned int irq;
+    unsigned int eip;
+    unsigned int cs;
+    unsigned int eflags;
+} trapframe_t;
+
+typedef void (*irq_handler_t)(trapframe_t *frame);
+
+void interrupts_init(void);
+void interrupts_enable(void);
+void interrupts_disable(void);
+unsigned int interrupts_save(void);
+void interrupts_restore(unsigned int flags);
+
+void interrupts_irq_register(int irq, irq_handler_t handler);
+
+void pic_irq_enable(int irq);
+void pic_irq_disable(int irq);
+void pic_irq_eoi(int irq);
+
+#endif
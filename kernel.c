@@ -9,128 +9,368 @@
 #include <spede/stdio.h>    // for printf
 #include <spede/string.h>   // string handling
 
+#include "counters.h"
+#include "fmt.h"
+#include "frame.h"
+#include "interrupts.h"
 #include "kernel.h"
+#include "kernel_log.h"
+#include "ksym.h"
+#include "prof.h"
+#include "sched.h"
+#include "serial.h"
+#include "slab.h"
+#include "trace.h"
 #include "vga.h"
+#include "vga_ext.h"
+#include "workq.h"
 #include "keyboard.h"
 
 #ifndef KERNEL_LOG_LEVEL_DEFAULT
 #define KERNEL_LOG_LEVEL_DEFAULT KERNEL_LOG_LEVEL_TRACE
 #endif
 
+// Number of records in the log ring (must be a power of two)
+#ifndef KERNEL_LOG_RING_RECORDS
+#define KERNEL_LOG_RING_RECORDS 64
+#endif
+
+// Maximum length of a formatted log message, including the terminator
+#define KERNEL_LOG_MSG_SIZE 120
+
+// Maximum length of a line printed to the host (a log message and its prefix)
+#define KERNEL_HOST_LINE_SIZE (KERNEL_LOG_MSG_SIZE + 16)
+
+// Number of records printed per call from the idle loop
+#define KERNEL_LOG_DRAIN_BATCH 8
+
+// Most stack frames printed by kernel_backtrace()
+#ifndef KERNEL_BACKTRACE_DEPTH
+#define KERNEL_BACKTRACE_DEPTH 16
+#endif
+
+// Largest gap between two frames before the walk is assumed to be lost
+#define KERNEL_BACKTRACE_MAX_FRAME 0x10000
+
+// Scratch memory for the panic message and backtrace lines
+#define KERNEL_SCRATCH_SIZE (2 * KERNEL_LOG_MSG_SIZE)
+
 // Current log level
 int kernel_log_level = KERNEL_LOG_LEVEL_DEFAULT;
 
 /**
- * Initializes any kernel internal data structures and variables
+ * Panic scratch arena
+ *
+ * The panic path formats into static memory rather than on the stack,
+ * which may be nearly used up by the time the kernel panics. It only runs
+ * with interrupts disabled and never returns, so the arena is reset at the
+ * start of each panic instead of being freed.
  */
-void kernel_init(void) {
-    // Display a welcome message on the host
-    kernel_log_info("Welcome to %s!", OS_NAME);
+static char kernel_scratch_mem[KERNEL_SCRATCH_SIZE];
+static arena_t kernel_scratch = { kernel_scratch_mem, KERNEL_SCRATCH_SIZE, 0, 0 };
 
-    kernel_log_info("Initializing kernel...");
-}
+/**
+ * Log ring
+ *
+ * Log messages are formatted into fixed-size records and printed to the
+ * host later by kernel_log_drain(). A writer reserves a record by moving
+ * log_head with interrupts briefly disabled, formats into it with
+ * interrupts enabled, and then marks it ready. The drain only consumes
+ * records in order once they are ready, so writers in interrupt handlers
+ * never wait on the host console.
+ */
+typedef struct log_record {
+    volatile bool ready;
+    int level;
+    char msg[KERNEL_LOG_MSG_SIZE];
+} log_record_t;
+
+static log_record_t log_ring[KERNEL_LOG_RING_RECORDS];
+static volatile unsigned int log_head = 0;  // next record to reserve
+static volatile unsigned int log_tail = 0;  // next record to drain
+static unsigned int log_dropped = 0;
+static unsigned int log_dropped_reported = 0;
+static bool log_draining = false;           // a task is printing records
+static wait_queue_t log_waiters;            // the log drain task, when idle
+
+// Message prefix for each log level
+static const char *log_prefix[] = {
+    [KERNEL_LOG_LEVEL_ERROR] = "error: ",
+    [KERNEL_LOG_LEVEL_WARN]  = "warn: ",
+    [KERNEL_LOG_LEVEL_INFO]  = "info: ",
+    [KERNEL_LOG_LEVEL_DEBUG] = "debug: ",
+    [KERNEL_LOG_LEVEL_TRACE] = "trace: ",
+};
 
 /**
- * Prints a kernel log message to the host with an error log level
+ * Prints to the host console and queues the same text on the serial port
  *
- * @param msg - string format for the message to be displayed
+ * Output longer than a host line is truncated. Uses no memory besides the
+ * stack, so it may be used from a panic.
+ *
+ * @param fmt - string format
  * @param ... - variable arguments to pass in to the string format
  */
-void kernel_log_error(char *msg, ...) {
-    // Implement me
-    if(kernel_log_level < KERNEL_LOG_LEVEL_ERROR)
-        return;
-    printf("error");
+void kernel_host_printf(const char *fmt, ...) {
+    char buf[KERNEL_HOST_LINE_SIZE];
     va_list args;
-    va_start(args, msg);
-    vprintf(msg, args);
+    int len;
+
+    va_start(args, fmt);
+    len = fmt_vsnprintf(buf, sizeof(buf), fmt, args);
     va_end(args);
-    printf("\n");
+
+    if (len > (int)sizeof(buf) - 1) {
+        len = sizeof(buf) - 1;
+    }
+
+    printf("%s", buf);
+    serial_write(buf, len);
 }
 
 /**
- * Prints a kernel log message to the host with a warning log level
+ * Logs a kernel message at the given log level: formats it into the next
+ * free record of the log ring
  *
- * @param msg - string format for the message to be displayed
- * @param ... - variable arguments to pass in to the string format
+ * The kernel log level is not checked here; KERNEL_LOG (through
+ * kernel_log_at) has already checked it. If the ring is full the message
+ * is dropped and counted. Levels outside ERROR..TRACE (such as
+ * KERNEL_LOG_LEVEL_ALL) are clamped into that range, since only those
+ * levels have a prefix.
+ *
+ * @param level - log level of the message
+ * @param msg - string format for the message
+ * @param args - variable arguments for the string format
  */
-void kernel_log_warn(char *msg, ...) {
-    // Implement me
-    if(kernel_log_level < KERNEL_LOG_LEVEL_WARN)
+void kernel_vlog(int level, char *msg, va_list args) {
+    unsigned int flags;
+    unsigned int head;
+
+    if (level < KERNEL_LOG_LEVEL_ERROR) {
+        level = KERNEL_LOG_LEVEL_ERROR;
+    } else if (level > KERNEL_LOG_LEVEL_TRACE) {
+        level = KERNEL_LOG_LEVEL_TRACE;
+    }
+
+    flags = interrupts_save();
+    head = log_head;
+
+    if (head - log_tail >= KERNEL_LOG_RING_RECORDS) {
+        log_dropped++;
+        COUNTER_INC(COUNTER_LOG_DROPS);
+        TRACE(TRACE_LOG_DROP, level, 0, 0, 0);
+        interrupts_restore(flags);
+        sched_wakeup(&log_waiters);
         return;
-    printf("warn");
-    va_list args;
-    va_start(args, msg);
-    vprintf(msg, args);
-    va_end(args);
-    printf("\n");
+    }
+    log_head = head + 1;
+    interrupts_restore(flags);
+
+    COUNTER_INC(COUNTER_LOG_ERROR + (level - KERNEL_LOG_LEVEL_ERROR));
+
+    log_record_t *rec = &log_ring[head & (KERNEL_LOG_RING_RECORDS - 1)];
+    rec->level = level;
+    fmt_vsnprintf(rec->msg, sizeof(rec->msg), msg, args);
+    __asm__ __volatile__("" ::: "memory");
+    rec->ready = true;
+    sched_wakeup(&log_waiters);
 }
 
 /**
- * Prints a kernel log message to the host with an info log level
+ * Prints waiting log records to the host
  *
- * @param msg - string format for the message to be displayed
- * @param ... - variable arguments to pass in to the string format
+ * The caller must be the only consumer of the ring: either it set
+ * log_draining, or no other task will run again.
+ *
+ * @param max - maximum number of records to print, or 0 for all of them
+ * @param force - print records that are still being formatted instead of
+ *                stopping at them, since their writers will not resume
+ * @return number of records printed
  */
-void kernel_log_info(char *msg, ...) {
-    // Return if our log level is less than info
-    if (kernel_log_level < KERNEL_LOG_LEVEL_INFO) {
-        return;
+static int kernel_log_print(int max, bool force) {
+    int count = 0;
+
+    while ((max <= 0 || count < max) && log_tail != log_head) {
+        log_record_t *rec = &log_ring[log_tail & (KERNEL_LOG_RING_RECORDS - 1)];
+
+        // Stop at a record that is still being formatted
+        if (!rec->ready && !force) {
+            break;
+        }
+
+        kernel_host_printf("%s%.*s\n", log_prefix[rec->level],
+                           (int)sizeof(rec->msg) - 1, rec->msg);
+        rec->ready = false;
+        __asm__ __volatile__("" ::: "memory");
+        log_tail++;
+        count++;
     }
 
-    // Obtain the list of variable arguments
-    va_list args;
+    if (log_dropped != log_dropped_reported) {
+        kernel_host_printf("%s%u log messages dropped\n", log_prefix[KERNEL_LOG_LEVEL_WARN],
+               log_dropped - log_dropped_reported);
+        log_dropped_reported = log_dropped;
+    }
+    return count;
+}
 
-    // Indicate this is an 'info' type of message
-    printf("info: ");
+/**
+ * Prints waiting log records to the host
+ *
+ * Returns right away if another task is already draining the ring.
+ *
+ * @param max - maximum number of records to print, or 0 for all of them
+ * @return number of records printed
+ */
+int kernel_log_drain(int max) {
+    unsigned int flags = interrupts_save();
+    int count;
+
+    // Only one task at a time may consume records
+    if (log_draining) {
+        interrupts_restore(flags);
+        return 0;
+    }
+    log_draining = true;
+    interrupts_restore(flags);
 
-    // Pass the message variable arguments to vprintf
-    va_start(args, msg);
-    vprintf(msg, args);
-    va_end(args);
+    count = kernel_log_print(max, false);
+
+    log_draining = false;
+    return count;
+}
 
-    printf("\n");
+/**
+ * Prints all waiting log records to the host
+ */
+void kernel_log_flush(void) {
+    kernel_log_drain(0);
 }
 
 /**
- * Prints a kernel log message to the host with a debug log level
+ * Prints all waiting log records to the host on the way out of the kernel
  *
- * @param msg - string format for the message to be displayed
- * @param ... - variable arguments to pass in to the string format
+ * Interrupts must be disabled. A task that was preempted while draining
+ * the ring never runs again, so its log_draining guard is ignored and the
+ * records it had not printed yet are printed here.
  */
-void kernel_log_debug(char *msg, ...) {
-    // Implement me
-     if(kernel_log_level < KERNEL_LOG_LEVEL_DEBUG)
-         return;
-     va_list args;
-     printf("debug");
-     va_start(args, msg);
-     vprintf(msg, args);
-     va_end(args);
-     printf("\n");
+static void kernel_log_flush_final(void) {
+    kernel_log_print(0, true);
 }
 
 /**
- * Prints a kernel log message to the host with a trace log level
+ * Halts the CPU until the next interrupt
  *
+ * Interrupts are enabled first. sti takes effect after the following
+ * instruction, so an interrupt that is already pending still ends the hlt
+ * instead of being taken before it.
+ */
+void kernel_idle(void) {
+    __asm__ __volatile__("sti; hlt" ::: "memory");
+}
+
+/**
+ * Indicates if the log drain task has something to print (interrupts must
+ * be disabled)
+ */
+static bool kernel_log_pending(void) {
+    return log_ring[log_tail & (KERNEL_LOG_RING_RECORDS - 1)].ready ||
+           log_dropped != log_dropped_reported;
+}
+
+/**
+ * Log drain task: sleeps until log records are written, then prints them
+ * to the host
+ */
+void kernel_log_task(void *arg) {
+    while (1) {
+        unsigned int flags = interrupts_save();
+        while (!kernel_log_pending()) {
+            sched_wait(&log_waiters);
+        }
+        interrupts_restore(flags);
+
+        if (kernel_log_drain(KERNEL_LOG_DRAIN_BATCH) == 0) {
+            // Another task is draining the ring; let it finish
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * Initializes any kernel internal data structures and variables
+ */
+void kernel_init(void) {
+    // Display a welcome message on the host
+    kernel_log_info("Welcome to %s!", OS_NAME);
+
+    kernel_log_info("Initializing kernel...");
+}
+
+/**
+ * Logs a kernel message at the given log level without checking the
+ * kernel log level (KERNEL_LOG has already checked it)
+ *
+ * @param level - log level of the message
  * @param msg - string format for the message to be displayed
  * @param ... - variable arguments to pass in to the string format
  */
-void kernel_log_trace(char *msg, ...) {
-    // Implement me
-    if(kernel_log_level < KERNEL_LOG_LEVEL_TRACE)
-        return;
-    printf("Trace");
+void kernel_log_at(int level, char *msg, ...) {
     va_list args;
+
     va_start(args, msg);
-    vprintf(msg, args);
+    kernel_vlog(level, msg, args);
     va_end(args);
-    printf("\n");
+}
+
+/**
+ * Prints the call stack to the host and the screen
+ *
+ * Follows the saved frame pointers (the kernel must be built with
+ * -fno-omit-frame-pointer) and names each return address from the kernel
+ * symbol table. Lines are formatted in the panic scratch arena, so it
+ * must be called with interrupts disabled, as from kernel_panic().
+ */
+void kernel_backtrace(void) {
+    unsigned long *frame = __builtin_frame_address(0);
+    char *line = arena_alloc(&kernel_scratch, KERNEL_LOG_MSG_SIZE);
+    int depth;
+
+    kernel_host_printf("backtrace:\n");
+    vga_printf("backtrace:\n");
+    if (!line) {
+        return;
+    }
+
+    for (depth = 0; depth < KERNEL_BACKTRACE_DEPTH && frame; depth++) {
+        unsigned long *next = (unsigned long *)frame[0];
+        unsigned long ret = frame[1];
+        unsigned int offset = 0;
+        const char *name = ksym_lookup(ret, &offset);
+
+        if (ret == 0) {
+            break;
+        }
+
+        fmt_snprintf(line, KERNEL_LOG_MSG_SIZE, "  #%-2d 0x%08x %s+0x%x\n",
+                     depth, (unsigned int)ret, name ? name : "?", offset);
+        kernel_host_printf("%s", line);
+        vga_puts(line);
+
+        // The stack grows down, so each caller's frame is above its callee's
+        if (next <= frame || ((unsigned long)next & (sizeof(*next) - 1)) ||
+            (unsigned long)next - (unsigned long)frame > KERNEL_BACKTRACE_MAX_FRAME) {
+            break;
+        }
+        frame = next;
+    }
 }
 
 /**
  * Triggers a kernel panic that does the following:
+ *   - Prints any waiting log messages to the host console
  *   - Displays a panic message on the host console
+ *   - Prints a symbolized backtrace and the VGA register state
  *   - Triggers a breakpiont (if running through GDB)
  *   - aborts/exits the operating system program
  *
@@ -138,11 +378,37 @@ void kernel_log_trace(char *msg, ...) {
  * @param ... - variable arguments to pass in to the string format
  */
 void kernel_panic(char *msg, ...) {
+    static bool panicking = false;
+    char *buf;
     va_list args;
+
+    interrupts_disable();
+
+    // Format once; the arguments can only be walked a single time
+    arena_reset(&kernel_scratch);
+    buf = arena_alloc(&kernel_scratch, KERNEL_LOG_MSG_SIZE);
     va_start(args, msg);
-    vprintf(msg, args);
+    fmt_vsnprintf(buf, KERNEL_LOG_MSG_SIZE, msg, args);
     va_end(args);
-    vga_printf("%s %s", msg, args);
+
+    // A panic while reporting a panic only gets the message
+    if (panicking) {
+        kernel_host_printf("panic: %s (while panicking)\n", buf);
+        serial_flush();
+        exit(1);
+    }
+    panicking = true;
+
+    kernel_log_flush_final();
+
+    kernel_host_printf("panic: %s\n", buf);
+    vga_printf("panic: %s\n", buf);
+
+    kernel_backtrace();
+    vga_dump_registers();
+
+    // The transmit interrupt cannot run now; send what is left by polling
+    serial_flush();
 
     // Trigger a breakpoint to inspect what caused the panic
     kernel_break();
@@ -176,7 +442,7 @@ int kernel_set_log_level(log_level_t level) {
     }
 
     if (prev_log_level != kernel_log_level) {
-        printf("<<kernel log level set to %d>>", kernel_log_level);
+        kernel_host_printf("<<kernel log level set to %d>>", kernel_log_level);
     }
 
     return kernel_log_level;
@@ -208,6 +474,72 @@ void kernel_command(char c) {
             kernel_break();
             break;
 
+        case 't':
+        case 'T':
+            // Dump the trace ring to the host (decode with tools/trace_decode)
+            kernel_log_flush();
+            trace_dump();
+            break;
+
+        case 's':
+        case 'S':
+            // Dump the instrumentation counters to the host and the screen
+            counters_dump();
+            break;
+
+        case 'r':
+        case 'R':
+            // Reset the instrumentation counters
+            counters_reset();
+            break;
+
+        case 'j':
+        case 'J':
+            // List the tasks
+            kernel_log_flush();
+            sched_dump();
+            break;
+
+        case 'w':
+        case 'W':
+            // Show the deferred work queue statistics
+            kernel_log_flush();
+            workq_dump();
+            break;
+
+        case 'u':
+        case 'U':
+            // Show the serial port statistics
+            kernel_log_flush();
+            serial_dump();
+            break;
+
+        case 'o':
+        case 'O':
+            // Start the sampling profiler (clears the previous profile)
+            prof_start();
+            break;
+
+        case 'x':
+        case 'X':
+            // Stop the sampling profiler
+            prof_stop();
+            break;
+
+        case 'h':
+        case 'H':
+            // Print the profiler hot spots to the host
+            kernel_log_flush();
+            prof_dump();
+            break;
+
+        case 'm':
+        case 'M':
+            // Log the frame allocator and kernel object cache usage
+            frame_dump();
+            slab_dump();
+            break;
+
         // Add new commands to:
         //  - Clear the screen (k)
         //  - Increase the kernel log level (+)
@@ -235,11 +567,20 @@ void kernel_command(char c) {
  * Exits the kernel
  */
 void kernel_exit(void) {
+    // No other task runs from here on
+    interrupts_disable();
+
+    // Print any waiting log messages
+    kernel_log_flush_final();
+
     // Print to the terminal
-    printf("Exiting %s...\n", OS_NAME);
+    kernel_host_printf("Exiting %s...\n", OS_NAME);
 
     // Print to the VGA display
     vga_printf("Exiting %s...\n", OS_NAME);
+
+    // Send what is left for the serial port before leaving
+    serial_flush();
     // Exit
     exit(0);
 }
@@ -0,0 +1,56 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Kernel logging macros
+ */
+#ifndef KERNEL_LOG_H
+#define KERNEL_LOG_H
+
+#include <spede/stdarg.h>
+
+#include "kernel.h"
+
+/**
+ * Least severe log level that is compiled in
+ *
+ * Log calls above this level are removed at compile time, including the
+ * evaluation of their arguments. Levels at or below it are still filtered
+ * at run time by the kernel log level.
+ */
+#ifndef KERNEL_LOG_LEVEL_MIN
+#define KERNEL_LOG_LEVEL_MIN KERNEL_LOG_LEVEL_ALL
+#endif
+
+// Current log level (as returned by kernel_get_log_level)
+extern int kernel_log_level;
+
+void kernel_vlog(int level, char *msg, va_list args);
+void kernel_log_at(int level, char *msg, ...);
+int kernel_log_drain(int max);
+void kernel_log_flush(void);
+void kernel_host_printf(const char *fmt, ...);
+void kernel_log_task(void *arg);
+void kernel_idle(void);
+void kernel_backtrace(void);
+
+/**
+ * Logs a message if its level is compiled in and enabled
+ *
+ * @param level - log level of the message
+ * @param ... - string format for the message followed by its arguments
+ */
+#define KERNEL_LOG(level, ...)                                                  \
+    do {                                                                        \
+        if ((level) <= KERNEL_LOG_LEVEL_MIN && kernel_log_level >= (level)) {   \
+            kernel_log_at((level), __VA_ARGS__);                                \
+        }                                                                       \
+    } while (0)
+
+#define kernel_log_error(...)   KERNEL_LOG(KERNEL_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define kernel_log_warn(...)    KERNEL_LOG(KERNEL_LOG_LEVEL_WARN, __VA_ARGS__)
+#define kernel_log_info(...)    KERNEL_LOG(KERNEL_LOG_LEVEL_INFO, __VA_ARGS__)
+#define kernel_log_debug(...)   KERNEL_LOG(KERNEL_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define kernel_log_trace(...)   KERNEL_LOG(KERNEL_LOG_LEVEL_TRACE, __VA_ARGS__)
+
+#endif
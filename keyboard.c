@@ -4,51 +4,368 @@
  *
  * Keyboard Functions
  */
+#include "counters.h"
+#include "interrupts.h"
 #include "io.h"
 #include "kernel.h"
+#include "kernel_log.h"
 #include "keyboard.h"
+#include "keyboard_ext.h"
+#include "ring.h"
+#include "sched.h"
+#include "trace.h"
+#include "vga.h"
+#include "vga_ext.h"
+#include "workq.h"
+
+/**
+ * Keyboard controller ports
+ */
+#define KBD_PORT_DATA       0x60
+#define KBD_PORT_STATUS     0x64
+#define KBD_STATUS_OUTPUT   0x01    // data is waiting in the output buffer
+
+/**
+ * Scancode set 1 values used while decoding
+ */
+#define SCANCODE_EXTENDED   0xE0    // prefix for extended keys
+#define SCANCODE_RELEASE    0x80    // set on key release (break) codes
+#define SCANCODE_ENTER      0x1C
+#define SCANCODE_SLASH      0x35
+#define SCANCODE_PAGE_UP    0x49    // extended
+#define SCANCODE_PAGE_DOWN  0x51    // extended
+#define SCANCODE_F1         0x3B
+#define SCANCODE_F4         0x3E
+
+/**
+ * Modifier state word
+ *
+ * The low three bits select the keymap plane, so decoding a key is one
+ * indexed load. CTRL and ALT do not change the character produced: CTRL
+ * makes up the KEY_KERNEL_DEBUG chord and ALT selects a virtual console.
+ */
+#define KBD_MOD_SHIFT       0x01
+#define KBD_MOD_CAPS        0x02
+#define KBD_MOD_NUMLOCK     0x04
+#define KBD_MOD_CTRL        0x08
+#define KBD_MOD_ALT         0x10
+#define KBD_MOD_TOGGLE      0x80    // flag in kbd_modifiers[]: key toggles instead of being held
+
+#define KBD_PLANES          8
+#define KBD_PLANE_MASK      (KBD_PLANES - 1)
+
+// Status keys making up the KEY_KERNEL_DEBUG chord (see main.c)
+#ifndef KBD_MOD_DEBUG
+#define KBD_MOD_DEBUG       KBD_MOD_CTRL
+#endif
+
+/**
+ * Scancode set 1 keymap
+ *
+ * Each entry is: scancode, character, shifted character, key type.
+ *   KBD_PLAIN  - SHIFT selects the shifted character
+ *   KBD_ALPHA  - SHIFT or CAPS (but not both) select upper case
+ *   KBD_KEYPAD - NUMLOCK selects the shifted (digit) character
+ */
+#define KBD_PLAIN   0
+#define KBD_ALPHA   1
+#define KBD_KEYPAD  2
+
+#define KBD_KEYS(X, p) \
+    X(p, 0x01, KEY_ESCAPE, KEY_ESCAPE, KBD_PLAIN) \
+    X(p, 0x02, '1', '!', KBD_PLAIN) \
+    X(p, 0x03, '2', '@', KBD_PLAIN) \
+    X(p, 0x04, '3', '#', KBD_PLAIN) \
+    X(p, 0x05, '4', '$', KBD_PLAIN) \
+    X(p, 0x06, '5', '%', KBD_PLAIN) \
+    X(p, 0x07, '6', '^', KBD_PLAIN) \
+    X(p, 0x08, '7', '&', KBD_PLAIN) \
+    X(p, 0x09, '8', '*', KBD_PLAIN) \
+    X(p, 0x0A, '9', '(', KBD_PLAIN) \
+    X(p, 0x0B, '0', ')', KBD_PLAIN) \
+    X(p, 0x0C, '-', '_', KBD_PLAIN) \
+    X(p, 0x0D, '=', '+', KBD_PLAIN) \
+    X(p, 0x0E, '\b', '\b', KBD_PLAIN) \
+    X(p, 0x0F, '\t', '\t', KBD_PLAIN) \
+    X(p, 0x10, 'q', 'Q', KBD_ALPHA) \
+    X(p, 0x11, 'w', 'W', KBD_ALPHA) \
+    X(p, 0x12, 'e', 'E', KBD_ALPHA) \
+    X(p, 0x13, 'r', 'R', KBD_ALPHA) \
+    X(p, 0x14, 't', 'T', KBD_ALPHA) \
+    X(p, 0x15, 'y', 'Y', KBD_ALPHA) \
+    X(p, 0x16, 'u', 'U', KBD_ALPHA) \
+    X(p, 0x17, 'i', 'I', KBD_ALPHA) \
+    X(p, 0x18, 'o', 'O', KBD_ALPHA) \
+    X(p, 0x19, 'p', 'P', KBD_ALPHA) \
+    X(p, 0x1A, '[', '{', KBD_PLAIN) \
+    X(p, 0x1B, ']', '}', KBD_PLAIN) \
+    X(p, 0x1C, '\n', '\n', KBD_PLAIN) \
+    X(p, 0x1E, 'a', 'A', KBD_ALPHA) \
+    X(p, 0x1F, 's', 'S', KBD_ALPHA) \
+    X(p, 0x20, 'd', 'D', KBD_ALPHA) \
+    X(p, 0x21, 'f', 'F', KBD_ALPHA) \
+    X(p, 0x22, 'g', 'G', KBD_ALPHA) \
+    X(p, 0x23, 'h', 'H', KBD_ALPHA) \
+    X(p, 0x24, 'j', 'J', KBD_ALPHA) \
+    X(p, 0x25, 'k', 'K', KBD_ALPHA) \
+    X(p, 0x26, 'l', 'L', KBD_ALPHA) \
+    X(p, 0x27, ';', ':', KBD_PLAIN) \
+    X(p, 0x28, '\'', '"', KBD_PLAIN) \
+    X(p, 0x29, '`', '~', KBD_PLAIN) \
+    X(p, 0x2B, '\\', '|', KBD_PLAIN) \
+    X(p, 0x2C, 'z', 'Z', KBD_ALPHA) \
+    X(p, 0x2D, 'x', 'X', KBD_ALPHA) \
+    X(p, 0x2E, 'c', 'C', KBD_ALPHA) \
+    X(p, 0x2F, 'v', 'V', KBD_ALPHA) \
+    X(p, 0x30, 'b', 'B', KBD_ALPHA) \
+    X(p, 0x31, 'n', 'N', KBD_ALPHA) \
+    X(p, 0x32, 'm', 'M', KBD_ALPHA) \
+    X(p, 0x33, ',', '<', KBD_PLAIN) \
+    X(p, 0x34, '.', '>', KBD_PLAIN) \
+    X(p, 0x35, '/', '?', KBD_PLAIN) \
+    X(p, 0x37, '*', '*', KBD_PLAIN) \
+    X(p, 0x39, ' ', ' ', KBD_PLAIN) \
+    X(p, 0x47, KEY_NULL, '7', KBD_KEYPAD) \
+    X(p, 0x48, KEY_NULL, '8', KBD_KEYPAD) \
+    X(p, 0x49, KEY_NULL, '9', KBD_KEYPAD) \
+    X(p, 0x4A, '-', '-', KBD_PLAIN) \
+    X(p, 0x4B, KEY_NULL, '4', KBD_KEYPAD) \
+    X(p, 0x4C, KEY_NULL, '5', KBD_KEYPAD) \
+    X(p, 0x4D, KEY_NULL, '6', KBD_KEYPAD) \
+    X(p, 0x4E, '+', '+', KBD_PLAIN) \
+    X(p, 0x4F, KEY_NULL, '1', KBD_KEYPAD) \
+    X(p, 0x50, KEY_NULL, '2', KBD_KEYPAD) \
+    X(p, 0x51, KEY_NULL, '3', KBD_KEYPAD) \
+    X(p, 0x52, KEY_NULL, '0', KBD_KEYPAD) \
+    X(p, 0x53, KEY_NULL, '.', KBD_KEYPAD)
+
+/**
+ * Character produced by a key in the plane for modifier state p
+ *
+ * Evaluated by the compiler when the keymap planes are built.
+ */
+#define KBD_CHAR(p, n, s, t) \
+    ((t) == KBD_ALPHA ? ((((p) & KBD_MOD_SHIFT) != 0) != (((p) & KBD_MOD_CAPS) != 0) ? (s) : (n)) : \
+     (t) == KBD_KEYPAD ? (((p) & KBD_MOD_NUMLOCK) ? (s) : (n)) : \
+     (((p) & KBD_MOD_SHIFT) ? (s) : (n)))
+#define KBD_ENTRY(p, code, n, s, t) [code] = KBD_CHAR(p, n, s, t),
+#define KBD_PLANE(p) { KBD_KEYS(KBD_ENTRY, p) }
+
+static const unsigned char kbd_keymap[KBD_PLANES][128] = {
+    KBD_PLANE(0), KBD_PLANE(1), KBD_PLANE(2), KBD_PLANE(3),
+    KBD_PLANE(4), KBD_PLANE(5), KBD_PLANE(6), KBD_PLANE(7),
+};
+
+/**
+ * Modifier bit for each scancode (0 for keys that are not modifiers)
+ *
+ * Extended right CTRL/ALT share the scancodes of the left keys.
+ */
+static const unsigned char kbd_modifiers[128] = {
+    [0x1D] = KBD_MOD_CTRL,
+    [0x2A] = KBD_MOD_SHIFT,
+    [0x36] = KBD_MOD_SHIFT,
+    [0x38] = KBD_MOD_ALT,
+    [0x3A] = KBD_MOD_CAPS | KBD_MOD_TOGGLE,
+    [0x45] = KBD_MOD_NUMLOCK | KBD_MOD_TOGGLE,
+};
+
+/**
+ * Global variables in this file scope
+ */
+static unsigned int kbd_mods = 0;           // current modifier state word
+static unsigned int kbd_toggles_held = 0;   // toggle keys currently held down
+static bool extended_prefix = false;
+
+// Raw scancodes from the IRQ handler (producer) to the bottom half (consumer)
+static ring_t scancode_ring;
+static unsigned int overflows_reported = 0;
+
+// Decoded keys from the bottom half (producer) to keyboard_poll (consumer)
+static ring_t key_ring;
+
+// Set while a bottom half is queued but has not started draining
+static volatile bool kbd_work_pending = false;
+
+// Tasks waiting in keyboard_getc for a key
+static wait_queue_t kbd_waiters;
+
+/**
+ * Hands a decoded key to keyboard_poll and wakes any waiting task
+ *
+ * Lets other input sources (such as the serial port) feed the keyboard.
+ * Keys are only produced from bottom halves on the work queue, which run
+ * one at a time, so the key ring keeps a single producer.
+ *
+ * @param key - decoded character
+ */
+void keyboard_put(unsigned int key) {
+    if (!ring_put(&key_ring, key)) {
+        COUNTER_INC(COUNTER_KBD_DROPS);
+        return;
+    }
+    sched_wakeup(&kbd_waiters);
+}
+
+/**
+ * Keyboard bottom half, run by the work queue with interrupts enabled
+ *
+ * Decodes every scancode in the scancode ring (which may run kernel
+ * commands or switch consoles) and hands the resulting keys to
+ * keyboard_poll.
+ */
+static void keyboard_bottom_half(unsigned int arg) {
+    unsigned char c;
+
+    // Clear first so a scancode arriving while we drain queues a new run
+    kbd_work_pending = false;
+
+    while (ring_get(&scancode_ring, &c)) {
+        unsigned int key = keyboard_decode(c);
+
+        if (key != KEY_NULL) {
+            keyboard_put(key);
+        }
+    }
+}
+
+/**
+ * Keyboard interrupt handler
+ *
+ * Moves every scancode waiting in the keyboard controller into the
+ * scancode ring and queues the bottom half to decode them, so the
+ * handler itself stays short.
+ */
+void keyboard_irq_handler(trapframe_t *frame) {
+    while (inportb(KBD_PORT_STATUS) & KBD_STATUS_OUTPUT) {
+        unsigned char c = inportb(KBD_PORT_DATA);
+
+        COUNTER_ADD(COUNTER_KBD_PORT_READS, 2);
+        COUNTER_INC(COUNTER_KBD_EVENTS);
+        TRACE(TRACE_KBD_SCANCODE, c, 0, 0, 0);
+        if (!ring_put(&scancode_ring, c)) {
+            COUNTER_INC(COUNTER_KBD_DROPS);
+        }
+    }
+    // The status read that ended the loop
+    COUNTER_INC(COUNTER_KBD_PORT_READS);
+
+    if (!kbd_work_pending && ring_count(&scancode_ring) > 0) {
+        kbd_work_pending = true;
+        if (!workq_queue(keyboard_bottom_half, 0)) {
+            // Try again on the next keyboard interrupt
+            kbd_work_pending = false;
+        }
+    }
+}
 
 /**
  * Initializes keyboard data structures and variables
  */
 void keyboard_init() {
     kernel_log_info("Initializing keyboard driver");
+
+    ring_init(&scancode_ring);
+    ring_init(&key_ring);
+    interrupts_irq_register(IRQ_KEYBOARD, keyboard_irq_handler);
 }
 
 /**
  * Scans for keyboard input and returns the raw character data
- * @return raw character data from the keyboard
+ *
+ * The scancode ring has a single consumer: the keyboard bottom half.
+ *
+ * @return raw character data from the keyboard, or KEY_NULL if none is waiting
  */
 unsigned int keyboard_scan(void) {
-    unsigned int c = KEY_NULL;
+    unsigned char c;
+
+    if (!ring_get(&scancode_ring, &c)) {
+        return KEY_NULL;
+    }
     return c;
 }
 
+/**
+ * Returns the number of scancodes dropped because the scancode ring was full
+ */
+unsigned int keyboard_overflows(void) {
+    return scancode_ring.overflows;
+}
+
 /**
  * Polls for a keyboard character to be entered.
  *
- * If a keyboard character data is present, will scan and return
- * the decoded keyboard output.
+ * Returns the next key decoded by the keyboard bottom half.
  *
- * @return decoded character or KEY_NULL (0) for any character
- *         that cannot be decoded
+ * @return decoded character or KEY_NULL (0) if no key is waiting
  */
 unsigned int keyboard_poll(void) {
-    unsigned int c = KEY_NULL;
-    return c;
+    unsigned int overflows = scancode_ring.overflows + key_ring.overflows;
+    unsigned char key;
+
+    if (overflows != overflows_reported) {
+        kernel_log_warn("keyboard: %u keys dropped", overflows - overflows_reported);
+        overflows_reported = overflows;
+    }
+
+    if (!ring_get(&key_ring, &key)) {
+        return KEY_NULL;
+    }
+    return key;
 }
 
 /**
  * Blocks until a keyboard character has been entered
- * @return decoded character entered by the keyboard or KEY_NULL
- *         for any character that cannot be decoded
+ *
+ * The calling task sleeps until the keyboard bottom half decodes a key,
+ * so other tasks (or the idle task) run in the meantime.
+ *
+ * @return decoded character entered by the keyboard
  */
 unsigned int keyboard_getc(void) {
     unsigned int c = KEY_NULL;
-    while ((c = keyboard_poll()) == KEY_NULL);
+    while ((c = keyboard_poll()) == KEY_NULL) {
+        unsigned int flags = interrupts_save();
+        while (ring_count(&key_ring) == 0) {
+            sched_wait(&kbd_waiters);
+        }
+        interrupts_restore(flags);
+    }
     return c;
 }
 
+/**
+ * Decodes a key that followed the extended (0xE0) prefix
+ *
+ * The keypad enter and slash keys map to their main keyboard characters.
+ * SHIFT with page up/down scrolls the VGA view through its history. All
+ * other extended keys (arrows, home, end, ...) cannot be mapped.
+ *
+ * @param code scancode with the release bit cleared
+ * @return decoded character or KEY_NULL
+ */
+static unsigned int keyboard_decode_extended(unsigned int code) {
+    switch (code) {
+        case SCANCODE_ENTER:
+            return '\n';
+
+        case SCANCODE_SLASH:
+            return '/';
+
+        case SCANCODE_PAGE_UP:
+        case SCANCODE_PAGE_DOWN:
+            if (kbd_mods & KBD_MOD_SHIFT) {
+                int lines = VGA_HEIGHT - 1;
+                vga_scrollback_view((code == SCANCODE_PAGE_UP) ? lines : -lines);
+            }
+            return KEY_NULL;
+
+        default:
+            return KEY_NULL;
+    }
+}
+
 /**
  * Processes raw keyboard input and decodes it.
  *
@@ -65,5 +382,64 @@ unsigned int keyboard_getc(void) {
  * function should be called.
  */
 unsigned int keyboard_decode(unsigned int c) {
-    return c;
+    bool extended = extended_prefix;
+    unsigned int code = c & ~SCANCODE_RELEASE;
+    unsigned int mod;
+
+    extended_prefix = false;
+    if (c == SCANCODE_EXTENDED) {
+        extended_prefix = true;
+        return KEY_NULL;
+    }
+    if (c > 0xFF) {
+        return KEY_NULL;
+    }
+
+    // Track the modifier keys
+    mod = kbd_modifiers[code];
+    if (mod) {
+        if (mod & KBD_MOD_TOGGLE) {
+            mod &= ~KBD_MOD_TOGGLE;
+            if (c & SCANCODE_RELEASE) {
+                kbd_toggles_held &= ~mod;
+            } else if (!(kbd_toggles_held & mod)) {
+                // Only toggle on the first make code, not on typematic repeats
+                kbd_toggles_held |= mod;
+                kbd_mods ^= mod;
+            }
+        } else if (!(extended && mod == KBD_MOD_SHIFT)) {
+            // Extended shift codes are "fake" shifts sent around other keys
+            if (c & SCANCODE_RELEASE) {
+                kbd_mods &= ~mod;
+            } else {
+                kbd_mods |= mod;
+            }
+        }
+        return KEY_NULL;
+    }
+
+    if (c & SCANCODE_RELEASE) {
+        return KEY_NULL;
+    }
+
+    if (extended) {
+        return keyboard_decode_extended(code);
+    }
+
+    // ALT with F1 to F4 switches virtual consoles
+    if ((kbd_mods & KBD_MOD_ALT) && code >= SCANCODE_F1 && code <= SCANCODE_F4) {
+        vga_console_switch(code - SCANCODE_F1);
+        return KEY_NULL;
+    }
+
+    // Debug chord: pass the key (without the chord applied) to the kernel
+    if ((kbd_mods & KBD_MOD_DEBUG) == KBD_MOD_DEBUG) {
+        unsigned int key = kbd_keymap[kbd_mods & KBD_PLANE_MASK & ~KBD_MOD_DEBUG][code];
+        if (key != KEY_NULL) {
+            kernel_command(key);
+        }
+        return KEY_NULL;
+    }
+
+    return kbd_keymap[kbd_mods & KBD_PLANE_MASK][code];
 }
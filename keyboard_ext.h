@@ -0,0 +1,15 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Keyboard Driver Extensions
+ */
+#ifndef KEYBOARD_EXT_H
+#define KEYBOARD_EXT_H
+
+#include "keyboard.h"
+
+void keyboard_put(unsigned int key);
+unsigned int keyboard_overflows(void);
+
+#endif
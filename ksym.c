@@ -0,0 +1,73 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Kernel Symbol Table
+ *
+ * The table is built in two link passes: the kernel is linked once without
+ * it, tools/ksymgen.sh turns the symbols of that image into a C source
+ * file, and the kernel is linked again with that file last. The generated
+ * file only holds read-only data, so no text address moves between the
+ * two passes.
+ */
+#include "ksym.h"
+
+/**
+ * Returns the number of symbols in the table (0 if it was not linked in)
+ */
+static unsigned int ksym_entries(void) {
+    return &ksym_count ? ksym_count : 0;
+}
+
+/**
+ * Finds the symbol containing an address
+ *
+ * Binary search for the last symbol starting at or below the address,
+ * so lookups are allocation free and safe from any context.
+ *
+ * @param addr - address to look up
+ * @param offset - if not null, set to the distance from the symbol start
+ * @return symbol name, or null if the address is not in the kernel text
+ */
+const char *ksym_lookup(unsigned int addr, unsigned int *offset) {
+    unsigned int count = ksym_entries();
+    unsigned int lo = 0;
+    unsigned int hi = count;
+
+    if (count == 0 || addr < ksym_table[0].addr || addr >= ksym_text_end) {
+        return 0;
+    }
+
+    // Invariant: ksym_table[lo].addr <= addr, and addr < ksym_table[hi].addr
+    while (hi - lo > 1) {
+        unsigned int mid = lo + (hi - lo) / 2;
+
+        if (ksym_table[mid].addr <= addr) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (offset) {
+        *offset = addr - ksym_table[lo].addr;
+    }
+    return &ksym_names[ksym_table[lo].name];
+}
+
+/**
+ * Gets the address range of the kernel text covered by the table
+ *
+ * @param start - set to the address of the first symbol
+ * @param end - set to the end of the text
+ * @return false if no symbol table was linked in
+ */
+bool ksym_text_range(unsigned int *start, unsigned int *end) {
+    if (ksym_entries() == 0) {
+        return false;
+    }
+
+    *start = ksym_table[0].addr;
+    *end = ksym_text_end;
+    return true;
+}
@@ -0,0 +1,35 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Kernel Symbol Table
+ */
+#ifndef KSYM_H
+#define KSYM_H
+
+#include <stdbool.h>
+
+/**
+ * A text symbol: its start address and the offset of its name in
+ * ksym_names. Entries are sorted by address.
+ */
+typedef struct ksym {
+    unsigned int addr;
+    unsigned int name;
+} ksym_t;
+
+/**
+ * Symbol table generated after linking by tools/ksymgen.sh
+ *
+ * Referenced weakly: a kernel linked without the generated table has
+ * ksym_count of 0 and resolves no symbols.
+ */
+extern const ksym_t ksym_table[] __attribute__((weak));
+extern const char ksym_names[] __attribute__((weak));
+extern const unsigned int ksym_count __attribute__((weak));
+extern const unsigned int ksym_text_end __attribute__((weak));
+
+const char *ksym_lookup(unsigned int addr, unsigned int *offset);
+bool ksym_text_range(unsigned int *start, unsigned int *end);
+
+#endif
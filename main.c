@@ -5,17 +5,73 @@
  * Operating system entry point
  */
 
+#include "kernel.h"
+#include "kernel_log.h"
 #include "vga.h"
+#include "vga_ext.h"
 #include "keyboard.h"
 #include "bit.h"
+#include "interrupts.h"
+#include "frame.h"
+#include "sched.h"
+#include "serial.h"
+#include "slab.h"
+#include "status.h"
+#include "timer.h"
+#include "workq.h"
+
+// Iterations of each workload burst, and timer ticks slept between bursts
+#define WORKLOAD_BURST          200000
+#define WORKLOAD_SLEEP_TICKS    (TIMER_HZ / 2)
+
+/**
+ * Background workload: bursts of CPU work separated by sleeps, so both
+ * preemption and idle time can be seen in the task list (CTRL-J)
+ */
+static void workload_task(void *arg) {
+    volatile unsigned int sum = 0;
+
+    while (1) {
+        for (unsigned int i = 0; i < WORKLOAD_BURST; i++) {
+            sum += bit_count(i);
+        }
+        sched_sleep(WORKLOAD_SLEEP_TICKS);
+    }
+}
 
 void main(void) {
+    status_field_t pos_field;
+
     // Initialize the VGA driver
     vga_init();
 
+    // Initialize the physical frame allocator
+    frame_init();
+
+    // Initialize the kernel object caches (backed by frames)
+    slab_init();
+
+    // Initialize interrupts before any driver registers a handler
+    interrupts_init();
+
     // Initialize the keyboard driver
     keyboard_init();
 
+    // Initialize the serial console (COM1)
+    serial_init();
+
+    // Start scheduling; main() continues as the shell task
+    sched_init();
+    timer_init(TIMER_HZ);
+    sched_spawn("log", kernel_log_task, 0);
+    sched_spawn("work", workload_task, 0);
+
+    // Start the worker task that runs interrupt bottom halves
+    workq_init();
+
+    // Start taking interrupts now that the handlers are in place
+    interrupts_enable();
+
     vga_printf("Welcome to %s!\n", OS_NAME);
 
     // Exercise the bit_* functions
@@ -60,6 +116,12 @@ void main(void) {
     vga_puts_at(VGA_HEIGHT-2, 0, VGA_COLOR_CYAN, VGA_COLOR_WHITE,
                "CTRL-P to test panic, CTRL-B for breakpoint");
 
+    // Keep the help text pinned below the scrolling output
+    vga_scroll_region(0, VGA_HEIGHT - 3);
+
+    // Live row/column indicator; only changed digits are redrawn
+    status_field_init(&pos_field, VGA_HEIGHT-1, 74, 6, VGA_COLOR_LIGHT_RED, VGA_COLOR_WHITE);
+
     vga_set_bg(VGA_COLOR_BLACK);
     vga_set_fg(VGA_COLOR_LIGHT_GREY);
 
@@ -68,22 +130,15 @@ void main(void) {
 
     keyboard_getc();
 
-    // Loop in place forever
+    // Loop in place forever, sleeping until each key is typed
     while (1) {
-        char c = keyboard_poll();
-        char buf[80] = {0};
+        char c = keyboard_getc();
 
-        if (c) {
-            // Print the character on the screen
-            vga_putc(c);
+        // Print the character on the screen
+        vga_putc(c);
 
-            // Copy the current x/y (cursor) position to a buffer
-            snprintf(buf, sizeof(buf), "%02d, %02d", vga_get_row(), vga_get_col());
-
-            // Print the buffer to the screen
-            vga_puts_at(VGA_HEIGHT-1, 74, VGA_COLOR_LIGHT_RED, VGA_COLOR_WHITE,
-                        buf);
-        }
+        // Show the current x/y (cursor) position
+        status_field_printf(&pos_field, "%02d, %02d", vga_get_row(), vga_get_col());
     }
 
     // We should never get here!
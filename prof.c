@@ -0,0 +1,145 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Sampling Profiler
+ *
+ * Every timer tick records the interrupted instruction pointer in a
+ * histogram whose buckets evenly cover the kernel text. A sample is one
+ * subtract, one shift and one increment, so the cost per tick is fixed.
+ * Hot buckets are resolved to symbols only when the profile is dumped.
+ */
+#include <spede/string.h>
+#include <stdbool.h>
+
+#include "kernel_log.h"
+#include "ksym.h"
+#include "prof.h"
+#include "trace.h"
+
+/**
+ * Global variables in this file scope
+ */
+static unsigned int prof_hist[PROF_BUCKETS];
+static volatile bool prof_running = false;
+static unsigned int prof_text_start = 0;
+static unsigned int prof_text_end = 0;
+static unsigned int prof_shift = PROF_BUCKET_SHIFT;
+static unsigned int prof_samples = 0;
+static unsigned int prof_outside = 0;       // samples outside the kernel text
+static unsigned int prof_max_cycles = 0;    // most cycles spent on one sample
+
+/**
+ * Clears the histogram and starts sampling
+ *
+ * The bucket size is the smallest power of two (at least
+ * 1 << PROF_BUCKET_SHIFT) that lets PROF_BUCKETS cover the kernel text.
+ */
+void prof_start(void) {
+    unsigned int start, end;
+
+    if (!ksym_text_range(&start, &end)) {
+        kernel_log_warn("prof: no symbol table linked in (see tools/ksymgen.sh)");
+        return;
+    }
+
+    prof_running = false;
+
+    prof_text_start = start;
+    prof_text_end = end;
+    prof_shift = PROF_BUCKET_SHIFT;
+    while (((end - start) >> prof_shift) >= PROF_BUCKETS) {
+        prof_shift++;
+    }
+
+    memset(prof_hist, 0, sizeof(prof_hist));
+    prof_samples = 0;
+    prof_outside = 0;
+    prof_max_cycles = 0;
+
+    kernel_log_info("prof: sampling 0x%08x-0x%08x in %u byte buckets",
+                    start, end, 1 << prof_shift);
+    prof_running = true;
+}
+
+/**
+ * Stops sampling, keeping the histogram for prof_dump()
+ */
+void prof_stop(void) {
+    prof_running = false;
+    kernel_log_info("prof: stopped after %u samples", prof_samples);
+}
+
+/**
+ * Records the interrupted instruction pointer
+ *
+ * Called from the timer interrupt handler.
+ *
+ * @param frame - register state of the interrupted code
+ */
+void prof_sample(trapframe_t *frame) {
+    unsigned long long tsc;
+    unsigned int eip, cycles;
+
+    if (!prof_running) {
+        return;
+    }
+
+    tsc = trace_rdtsc();
+    eip = frame->eip;
+    prof_samples++;
+
+    if (eip >= prof_text_start && eip < prof_text_end) {
+        prof_hist[(eip - prof_text_start) >> prof_shift]++;
+    } else {
+        prof_outside++;
+    }
+
+    cycles = (unsigned int)(trace_rdtsc() - tsc);
+    if (cycles > prof_max_cycles) {
+        prof_max_cycles = cycles;
+    }
+}
+
+/**
+ * Prints the hottest PROF_TOP buckets to the host, with the symbol each
+ * bucket starts in
+ */
+void prof_dump(void) {
+    unsigned int top[PROF_TOP];
+    unsigned int top_count = 0;
+    unsigned int samples = prof_samples;
+    unsigned int i, j;
+
+    kernel_host_printf("prof: %u samples, %u outside the text, max %u cycles per sample%s\n",
+                       samples, prof_outside, prof_max_cycles, prof_running ? " (running)" : "");
+    if (samples == 0) {
+        return;
+    }
+
+    // Insertion into a short sorted list of the hottest buckets
+    for (i = 0; i < PROF_BUCKETS; i++) {
+        unsigned int hits = prof_hist[i];
+
+        if (hits == 0 || (top_count == PROF_TOP && hits <= prof_hist[top[top_count - 1]])) {
+            continue;
+        }
+
+        j = (top_count < PROF_TOP) ? top_count++ : top_count - 1;
+        while (j > 0 && prof_hist[top[j - 1]] < hits) {
+            top[j] = top[j - 1];
+            j--;
+        }
+        top[j] = i;
+    }
+
+    for (i = 0; i < top_count; i++) {
+        unsigned int hits = prof_hist[top[i]];
+        unsigned int addr = prof_text_start + (top[i] << prof_shift);
+        unsigned int offset = 0;
+        const char *name = ksym_lookup(addr, &offset);
+
+        kernel_host_printf("  %6u %3u%% 0x%08x %s+0x%x\n", hits, hits * 100 / samples,
+                           addr, name ? name : "?", offset);
+    }
+}
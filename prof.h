@@ -0,0 +1,32 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Sampling Profiler
+ */
+#ifndef PROF_H
+#define PROF_H
+
+#include "interrupts.h"
+
+// Number of histogram buckets covering the kernel text
+#ifndef PROF_BUCKETS
+#define PROF_BUCKETS 4096
+#endif
+
+// Smallest bucket size, as a power of two in bytes
+#ifndef PROF_BUCKET_SHIFT
+#define PROF_BUCKET_SHIFT 4
+#endif
+
+// Number of hot spots printed by prof_dump()
+#ifndef PROF_TOP
+#define PROF_TOP 10
+#endif
+
+void prof_start(void);
+void prof_stop(void);
+void prof_sample(trapframe_t *frame);
+void prof_dump(void);
+
+#endif
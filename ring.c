@@ -0,0 +1,69 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Single-producer/single-consumer byte ring buffer
+ */
+#include "ring.h"
+
+// Keeps the compiler from moving buffer accesses across index updates
+#define ring_barrier() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * Initializes a ring to empty
+ * @param ring - the ring to initialize
+ */
+void ring_init(ring_t *ring) {
+    ring->head = 0;
+    ring->tail = 0;
+    ring->overflows = 0;
+}
+
+/**
+ * Adds a byte to the ring (producer side)
+ *
+ * @param ring - the ring to add to
+ * @param c - the byte to add
+ * @return true if added, false if the ring was full and the byte dropped
+ */
+bool ring_put(ring_t *ring, unsigned char c) {
+    unsigned int head = ring->head;
+
+    if (head - ring->tail >= RING_SIZE) {
+        ring->overflows++;
+        return false;
+    }
+
+    ring->buf[head & (RING_SIZE - 1)] = c;
+    ring_barrier();
+    ring->head = head + 1;
+    return true;
+}
+
+/**
+ * Removes the oldest byte from the ring (consumer side)
+ *
+ * @param ring - the ring to remove from
+ * @param c - where to store the byte
+ * @return true if a byte was removed, false if the ring was empty
+ */
+bool ring_get(ring_t *ring, unsigned char *c) {
+    unsigned int tail = ring->tail;
+
+    if (tail == ring->head) {
+        return false;
+    }
+
+    *c = ring->buf[tail & (RING_SIZE - 1)];
+    ring_barrier();
+    ring->tail = tail + 1;
+    return true;
+}
+
+/**
+ * Returns the number of bytes waiting in the ring
+ * @param ring - the ring to check
+ */
+unsigned int ring_count(ring_t *ring) {
+    return ring->head - ring->tail;
+}
@@ -0,0 +1,35 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Single-producer/single-consumer byte ring buffer
+ */
+#ifndef RING_H
+#define RING_H
+
+#include <stdbool.h>
+
+// Number of bytes a ring can hold (must be a power of two)
+#define RING_SIZE 256
+
+/**
+ * Ring buffer state
+ *
+ * head and tail count up forever and are masked when indexing, so a full
+ * ring (head - tail == RING_SIZE) can be told apart from an empty one.
+ * Only the producer writes head and only the consumer writes tail, so one
+ * side may run in an interrupt handler without any locking.
+ */
+typedef struct ring {
+    volatile unsigned int head;     // next slot to write (producer only)
+    volatile unsigned int tail;     // next slot to read (consumer only)
+    unsigned int overflows;         // bytes dropped because the ring was full
+    unsigned char buf[RING_SIZE];
+} ring_t;
+
+void ring_init(ring_t *ring);
+bool ring_put(ring_t *ring, unsigned char c);
+bool ring_get(ring_t *ring, unsigned char *c);
+unsigned int ring_count(ring_t *ring);
+
+#endif
@@ -0,0 +1,461 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Scheduler Functions
+ *
+ * Round-robin scheduling of kernel tasks. Every switch happens on the way
+ * out of an interrupt: the interrupted task's trapframe is saved in its
+ * control block and the trapframe of the next ready task is returned to
+ * the entry stub, which resumes it. Timer ticks preempt the running task
+ * when its quantum is used up; sched_yield() raises a software interrupt
+ * to switch right away.
+ *
+ * Tasks waiting for an event are kept off the run queue. When no task is
+ * ready, the idle task halts the CPU until the next interrupt.
+ */
+#include <spede/machine/proc_reg.h>     // for get_cs()
+#include <spede/string.h>
+#include <stdbool.h>
+
+#include "counters.h"
+#include "frame.h"
+#include "interrupts.h"
+#include "kernel.h"
+#include "kernel_log.h"
+#include "sched.h"
+#include "slab.h"
+#include "trace.h"
+
+// Stack size of a spawned task (one frame)
+#define SCHED_STACK_SIZE FRAME_SIZE
+
+// Flags a new task starts with: interrupts enabled (bit 1 is always set)
+#define SCHED_EFLAGS_INIT 0x202
+
+/**
+ * Global variables in this file scope
+ */
+static slab_cache_t task_cache;
+static task_t boot_task;                // the thread of control main() runs in
+static task_t *current = 0;             // running task, 0 until sched_init()
+static task_t *idle_task = 0;           // runs only when no other task is ready
+static task_t *run_head = 0;            // next ready task to run
+static task_t *run_tail = 0;
+static task_t *dead_list = 0;           // exited tasks waiting for sched_reap()
+static task_t *all_tasks = 0;           // every task that has not been reaped
+static task_t *sleep_list = 0;          // sleeping tasks, soonest wake first
+static unsigned int sched_ticks = 0;
+static unsigned int idle_ticks = 0;
+static unsigned int busy_ticks = 0;
+static int next_pid = 1;
+static int slice = SCHED_QUANTUM;       // ticks left in the current quantum
+static bool need_resched = false;
+
+static const char *task_state_names[] = {
+    [TASK_READY]   = "ready",
+    [TASK_RUNNING] = "running",
+    [TASK_BLOCKED] = "blocked",
+    [TASK_DEAD]    = "dead",
+};
+
+/**
+ * Adds a task to the tail of the run queue (interrupts must be disabled)
+ */
+static void sched_enqueue(task_t *task) {
+    task->state = TASK_READY;
+    task->next = 0;
+    if (run_tail) {
+        run_tail->next = task;
+    } else {
+        run_head = task;
+    }
+    run_tail = task;
+}
+
+/**
+ * Removes the task at the head of the run queue (interrupts must be
+ * disabled)
+ *
+ * @return the task, or 0 if no task is ready
+ */
+static task_t *sched_dequeue(void) {
+    task_t *task = run_head;
+
+    if (task) {
+        run_head = task->next;
+        if (!run_head) {
+            run_tail = 0;
+        }
+        task->next = 0;
+    }
+    return task;
+}
+
+/**
+ * First code run by a spawned task: calls the entry function and exits
+ * the task when it returns
+ */
+static void sched_task_start(void) {
+    current->entry(current->arg);
+    sched_exit();
+}
+
+/**
+ * Idle task: halts until an interrupt, over and over
+ */
+static void sched_idle(void *arg) {
+    while (1) {
+        sched_reap();
+        kernel_idle();
+    }
+}
+
+/**
+ * Creates a task without making it ready to run
+ *
+ * @return the new task, or 0 if memory could not be allocated
+ */
+static task_t *sched_create(const char *name, task_entry_t entry, void *arg) {
+    unsigned int flags;
+    task_t *task;
+    unsigned int stack;
+
+    sched_reap();
+
+    flags = interrupts_save();
+    task = slab_alloc(&task_cache);
+    stack = task ? frame_alloc() : 0;
+    if (task && !stack) {
+        slab_free(task);
+    }
+    interrupts_restore(flags);
+
+    if (!stack) {
+        kernel_log_error("sched: unable to allocate task %s", name);
+        return 0;
+    }
+
+    memset(task, 0, sizeof(*task));
+    task->name = name;
+    task->entry = entry;
+    task->arg = arg;
+    task->stack = stack;
+
+    // Build the trapframe the task is first resumed from at the top of
+    // its stack, as if it had been interrupted at sched_task_start
+    trapframe_t *frame = (trapframe_t *)(unsigned long)(stack + SCHED_STACK_SIZE) - 1;
+    memset(frame, 0, sizeof(*frame));
+    frame->eip = (unsigned long)sched_task_start;
+    frame->cs = get_cs();
+    frame->eflags = SCHED_EFLAGS_INIT;
+    task->frame = frame;
+
+    flags = interrupts_save();
+    task->pid = next_pid++;
+    task->all_next = all_tasks;
+    all_tasks = task;
+    interrupts_restore(flags);
+
+    return task;
+}
+
+/**
+ * Initializes the scheduler
+ *
+ * The code calling this function becomes the first task.
+ */
+void sched_init(void) {
+    kernel_log_info("Initializing scheduler");
+
+    slab_cache_init(&task_cache, "task", sizeof(task_t));
+
+    boot_task.pid = 0;
+    boot_task.name = "shell";
+    boot_task.state = TASK_RUNNING;
+    all_tasks = &boot_task;
+    current = &boot_task;
+
+    idle_task = sched_create("idle", sched_idle, 0);
+    if (!idle_task) {
+        kernel_panic("sched: unable to create the idle task");
+    }
+}
+
+/**
+ * Creates a task and adds it to the run queue
+ *
+ * @param name - name shown in the task list
+ * @param entry - function the task runs; the task exits when it returns
+ * @param arg - argument passed to the entry function
+ * @return the new task, or 0 if memory could not be allocated
+ */
+task_t *sched_spawn(const char *name, task_entry_t entry, void *arg) {
+    task_t *task = sched_create(name, entry, arg);
+
+    if (task) {
+        unsigned int flags = interrupts_save();
+        sched_enqueue(task);
+        interrupts_restore(flags);
+
+        kernel_log_debug("sched: spawned task %d (%s)", task->pid, name);
+    }
+    return task;
+}
+
+/**
+ * Gives up the CPU to the next ready task
+ *
+ * Does nothing before sched_init().
+ */
+void sched_yield(void) {
+    if (!current) {
+        return;
+    }
+    __asm__ __volatile__("int %0" :: "i"(IRQ_BASE + IRQ_YIELD) : "memory");
+}
+
+/**
+ * Ends the running task
+ *
+ * Its stack and control block are freed later by sched_reap().
+ */
+void sched_exit(void) {
+    interrupts_disable();
+    current->state = TASK_DEAD;
+    sched_yield();
+
+    // Never resumed
+    kernel_panic("sched: dead task %d resumed", current->pid);
+}
+
+/**
+ * Frees the stacks and control blocks of tasks that have exited
+ *
+ * Runs in task context since the allocators are not used from interrupt
+ * handlers.
+ */
+void sched_reap(void) {
+    unsigned int flags = interrupts_save();
+
+    while (dead_list) {
+        task_t *task = dead_list;
+        dead_list = task->next;
+
+        for (task_t **link = &all_tasks; *link; link = &(*link)->all_next) {
+            if (*link == task) {
+                *link = task->all_next;
+                break;
+            }
+        }
+        frame_free(task->stack);
+        slab_free(task);
+    }
+    interrupts_restore(flags);
+}
+
+/**
+ * Returns the running task
+ */
+task_t *sched_current(void) {
+    return current;
+}
+
+/**
+ * Makes a blocked task ready to run (interrupts must be disabled)
+ *
+ * If the CPU is idle, a switch is requested so the task runs as soon as
+ * the current interrupt returns.
+ */
+static void sched_ready(task_t *task) {
+    sched_enqueue(task);
+    if (current == idle_task) {
+        need_resched = true;
+    }
+}
+
+/**
+ * Blocks the running task on a wait queue until sched_wakeup() is called
+ *
+ * Must be called with interrupts disabled, after checking the condition
+ * being waited for, so a wakeup cannot be missed in between:
+ *
+ *     flags = interrupts_save();
+ *     while (!condition) {
+ *         sched_wait(&wq);
+ *     }
+ *     interrupts_restore(flags);
+ *
+ * Before sched_init() there is nothing to switch to, so this halts until
+ * the next interrupt instead.
+ *
+ * @param wq - wait queue to block on
+ */
+void sched_wait(wait_queue_t *wq) {
+    if (!current) {
+        kernel_idle();
+        interrupts_disable();
+        return;
+    }
+
+    current->state = TASK_BLOCKED;
+    current->next = 0;
+    if (wq->tail) {
+        wq->tail->next = current;
+    } else {
+        wq->head = current;
+    }
+    wq->tail = current;
+
+    sched_yield();
+}
+
+/**
+ * Makes every task blocked on a wait queue ready to run
+ *
+ * May be called from interrupt handlers.
+ *
+ * @param wq - wait queue to wake
+ */
+void sched_wakeup(wait_queue_t *wq) {
+    unsigned int flags = interrupts_save();
+
+    while (wq->head) {
+        task_t *task = wq->head;
+        wq->head = task->next;
+        sched_ready(task);
+    }
+    wq->tail = 0;
+    interrupts_restore(flags);
+}
+
+/**
+ * Blocks the running task for a number of timer ticks
+ *
+ * @param ticks - ticks to sleep for
+ */
+void sched_sleep(unsigned int ticks) {
+    unsigned int flags;
+    task_t **link;
+
+    if (!current || ticks == 0) {
+        return;
+    }
+
+    flags = interrupts_save();
+    current->state = TASK_BLOCKED;
+    current->wake_tick = sched_ticks + ticks;
+
+    // Keep the list ordered so the timer tick only checks the head
+    for (link = &sleep_list; *link; link = &(*link)->next) {
+        if ((int)((*link)->wake_tick - current->wake_tick) > 0) {
+            break;
+        }
+    }
+    current->next = *link;
+    *link = current;
+
+    sched_yield();
+    interrupts_restore(flags);
+}
+
+/**
+ * Accounts a timer tick to the running task and requests a switch when
+ * its quantum is used up
+ *
+ * Called from the timer interrupt handler.
+ */
+void sched_tick(void) {
+    if (!current) {
+        return;
+    }
+
+    sched_ticks++;
+    while (sleep_list && (int)(sleep_list->wake_tick - sched_ticks) <= 0) {
+        task_t *task = sleep_list;
+        sleep_list = task->next;
+        sched_ready(task);
+    }
+
+    current->ticks++;
+    if (current == idle_task) {
+        idle_ticks++;
+        COUNTER_INC(COUNTER_SCHED_IDLE_TICKS);
+    } else {
+        busy_ticks++;
+        COUNTER_INC(COUNTER_SCHED_BUSY_TICKS);
+    }
+
+    if (--slice <= 0) {
+        need_resched = true;
+    }
+}
+
+/**
+ * Requests a switch at the next interrupt exit
+ */
+void sched_preempt(void) {
+    need_resched = true;
+}
+
+/**
+ * Picks the task to resume when leaving an interrupt
+ *
+ * Called by the interrupt entry code with interrupts disabled. The running
+ * task goes to the back of the run queue (unless it blocked or exited)
+ * and the task at the front is resumed, or the idle task if none is ready.
+ *
+ * @param frame - register state of the interrupted task
+ * @return the register state to resume
+ */
+trapframe_t *sched_irq_exit(trapframe_t *frame) {
+    if (!need_resched || !current) {
+        return frame;
+    }
+    need_resched = false;
+
+    task_t *prev = current;
+    prev->frame = frame;
+
+    if (prev->state == TASK_RUNNING && prev != idle_task) {
+        sched_enqueue(prev);
+    }
+
+    task_t *next = sched_dequeue();
+    if (!next) {
+        next = idle_task;
+    }
+
+    if (prev->state == TASK_DEAD && prev != &boot_task) {
+        prev->next = dead_list;
+        dead_list = prev;
+    }
+
+    next->state = TASK_RUNNING;
+    slice = SCHED_QUANTUM;
+    current = next;
+
+    if (next != prev) {
+        next->switches++;
+        COUNTER_INC(COUNTER_SCHED_SWITCHES);
+        TRACE(TRACE_SCHED_SWITCH, prev->pid, next->pid, 0, 0);
+    }
+    return next->frame;
+}
+
+/**
+ * Prints the task list to the host
+ */
+void sched_dump(void) {
+    unsigned int flags = interrupts_save();
+
+    unsigned int total = idle_ticks + busy_ticks;
+
+    kernel_host_printf("tasks: %u ticks idle, %u busy (%u%% idle)\n", idle_ticks, busy_ticks,
+                       total ? idle_ticks * 100 / total : 0);
+    for (task_t *task = all_tasks; task; task = task->all_next) {
+        kernel_host_printf("  %3d %-8s %-8s ticks=%u switches=%u\n", task->pid, task->name,
+                           task_state_names[task->state], task->ticks, task->switches);
+    }
+    interrupts_restore(flags);
+}
@@ -0,0 +1,72 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Scheduler Functions
+ */
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "interrupts.h"
+
+// Timer ticks a task runs before it is preempted
+#ifndef SCHED_QUANTUM
+#define SCHED_QUANTUM 2
+#endif
+
+typedef enum task_state {
+    TASK_READY,
+    TASK_RUNNING,
+    TASK_BLOCKED,
+    TASK_DEAD
+} task_state_t;
+
+typedef void (*task_entry_t)(void *arg);
+
+/**
+ * Process control block
+ *
+ * A task that is not running has its registers saved in a trapframe on
+ * its own stack; switching to it is a matter of resuming that trapframe.
+ */
+typedef struct task {
+    int pid;
+    const char *name;
+    task_state_t state;
+    trapframe_t *frame;         // saved registers while not running
+    unsigned int stack;         // stack frame, 0 for the boot task
+    task_entry_t entry;
+    void *arg;
+    unsigned int ticks;         // timer ticks spent running
+    unsigned int switches;      // times the task was switched to
+    unsigned int wake_tick;     // tick a sleeping task is due to wake at
+    struct task *next;          // run queue (or wait/dead list) link
+    struct task *all_next;      // list of all tasks
+} task_t;
+
+/**
+ * Tasks blocked until an event is signaled with sched_wakeup()
+ */
+typedef struct wait_queue {
+    task_t *head;
+    task_t *tail;
+} wait_queue_t;
+
+void sched_init(void);
+task_t *sched_spawn(const char *name, task_entry_t entry, void *arg);
+void sched_yield(void);
+void sched_exit(void);
+void sched_reap(void);
+task_t *sched_current(void);
+
+void sched_wait(wait_queue_t *wq);
+void sched_wakeup(wait_queue_t *wq);
+void sched_sleep(unsigned int ticks);
+
+void sched_tick(void);
+void sched_preempt(void);
+trapframe_t *sched_irq_exit(trapframe_t *frame);
+
+void sched_dump(void);
+
+#endif
@@ -0,0 +1,375 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Serial Port (16550 UART) Functions
+ *
+ * Output is copied into a transmit ring and sent by the interrupt handler
+ * when the UART reports its transmitter empty (THRE), up to a full
+ * 16-byte FIFO per interrupt, so writers never wait on the line. When the
+ * ring is full the bytes that do not fit are dropped and counted.
+ *
+ * Received bytes are moved into a receive ring by the interrupt handler
+ * and handed to the keyboard as an alternate input source by a bottom
+ * half on the work queue.
+ *
+ * All register access goes through SERIAL_INB/SERIAL_OUTB, which a host
+ * build may define to drive a simulated UART instead of the ports.
+ */
+#include "counters.h"
+#include "interrupts.h"
+#include "io.h"
+#include "kernel.h"
+#include "kernel_log.h"
+#include "keyboard.h"
+#include "keyboard_ext.h"
+#include "ring.h"
+#include "serial.h"
+#include "timer.h"
+#include "workq.h"
+
+#ifndef SERIAL_INB
+#define SERIAL_INB(reg)         inportb(SERIAL_COM1 + (reg))
+#define SERIAL_OUTB(reg, value) outportb(SERIAL_COM1 + (reg), (value))
+#endif
+
+/**
+ * UART registers (offsets from the I/O base)
+ */
+#define UART_RBR    0   // receive buffer (read)
+#define UART_THR    0   // transmit holding (write)
+#define UART_DLL    0   // divisor latch low (DLAB set)
+#define UART_IER    1   // interrupt enable
+#define UART_DLM    1   // divisor latch high (DLAB set)
+#define UART_IIR    2   // interrupt identification (read)
+#define UART_FCR    2   // FIFO control (write)
+#define UART_LCR    3   // line control
+#define UART_MCR    4   // modem control
+#define UART_LSR    5   // line status
+#define UART_MSR    6   // modem status
+#define UART_SCR    7   // scratch
+
+#define UART_IER_RDA        0x01    // received data available
+#define UART_IER_THRE       0x02    // transmit holding register empty
+#define UART_IER_RLS        0x04    // receiver line status
+
+#define UART_IIR_NONE       0x01    // no interrupt pending
+#define UART_IIR_ID_MASK    0x0E
+#define UART_IIR_MSR        0x00
+#define UART_IIR_THRE       0x02
+#define UART_IIR_RDA        0x04
+#define UART_IIR_RLS        0x06
+#define UART_IIR_TIMEOUT    0x0C
+
+// Enable and clear both FIFOs, receive interrupt at 14 bytes
+#define UART_FCR_INIT       0xC7
+
+#define UART_LCR_8N1        0x03
+#define UART_LCR_DLAB       0x80
+
+// DTR, RTS and OUT2 (OUT2 gates the interrupt line on PC serial ports)
+#define UART_MCR_INIT       0x0B
+
+#define UART_LSR_DR         0x01    // data ready
+#define UART_LSR_OE         0x02    // overrun error
+#define UART_LSR_THRE       0x20    // transmit FIFO empty
+
+// Bytes the transmit FIFO takes at once
+#define UART_TX_FIFO        16
+
+// UART input clock divided by 16
+#define UART_CLOCK          115200
+
+// Most interrupt causes handled per interrupt
+#define SERIAL_IRQ_LOOPS    16
+
+// Spins waiting for the transmitter in serial_flush() before giving up
+#define SERIAL_FLUSH_SPINS  100000
+
+/**
+ * Global variables in this file scope
+ */
+static bool uart_present = false;
+static unsigned char uart_ier = 0;
+
+static char tx_buf[SERIAL_TX_SIZE];
+static volatile unsigned int tx_head = 0;   // next byte to queue
+static volatile unsigned int tx_tail = 0;   // next byte to send
+
+// Received bytes from the IRQ handler (producer) to the bottom half (consumer)
+static ring_t rx_ring;
+static volatile bool rx_work_pending = false;
+
+static serial_stats_t serial_stat;
+static unsigned int serial_start_tick = 0;
+
+/**
+ * Moves up to a FIFO's worth of queued bytes into the transmitter, and
+ * enables the THRE interrupt only while bytes remain queued
+ *
+ * Interrupts must be disabled.
+ */
+static void serial_tx_fill(void) {
+    unsigned char ier;
+
+    if (tx_tail != tx_head && (SERIAL_INB(UART_LSR) & UART_LSR_THRE)) {
+        int count = 0;
+
+        while (count < UART_TX_FIFO && tx_tail != tx_head) {
+            SERIAL_OUTB(UART_THR, tx_buf[tx_tail & (SERIAL_TX_SIZE - 1)]);
+            tx_tail++;
+            count++;
+        }
+
+        serial_stat.tx_bytes += count;
+        serial_stat.tx_bursts++;
+        COUNTER_ADD(COUNTER_SERIAL_TX_BYTES, count);
+    }
+
+    ier = (tx_tail != tx_head) ? (uart_ier | UART_IER_THRE) : (uart_ier & ~UART_IER_THRE);
+    if (ier != uart_ier) {
+        uart_ier = ier;
+        SERIAL_OUTB(UART_IER, uart_ier);
+    }
+}
+
+/**
+ * Serial bottom half: hands received bytes to the keyboard
+ *
+ * Carriage returns become new-lines and DEL becomes backspace, as sent by
+ * most terminals for the enter and backspace keys.
+ */
+static void serial_rx_bottom_half(unsigned int arg) {
+    unsigned char c;
+
+    // Clear first so a byte arriving while we drain queues a new run
+    rx_work_pending = false;
+
+    while (ring_get(&rx_ring, &c)) {
+        if (c == '\r') {
+            c = '\n';
+        } else if (c == 0x7F) {
+            c = '\b';
+        }
+        keyboard_put(c);
+    }
+}
+
+/**
+ * Reads every byte waiting in the receiver into the receive ring
+ */
+static void serial_rx_drain(void) {
+    unsigned char lsr;
+
+    while ((lsr = SERIAL_INB(UART_LSR)) & UART_LSR_DR) {
+        unsigned char c = SERIAL_INB(UART_RBR);
+
+        if (lsr & UART_LSR_OE) {
+            serial_stat.rx_overruns++;
+        }
+
+        serial_stat.rx_bytes++;
+        COUNTER_INC(COUNTER_SERIAL_RX_BYTES);
+        if (!ring_put(&rx_ring, c)) {
+            serial_stat.rx_drops++;
+            COUNTER_INC(COUNTER_SERIAL_RX_DROPS);
+        }
+    }
+
+    if (!rx_work_pending && ring_count(&rx_ring) > 0) {
+        rx_work_pending = true;
+        if (!workq_queue(serial_rx_bottom_half, 0)) {
+            // Try again on the next receive interrupt
+            rx_work_pending = false;
+        }
+    }
+}
+
+/**
+ * Serial interrupt handler
+ *
+ * Handles every cause the UART reports, up to SERIAL_IRQ_LOOPS of them.
+ */
+static void serial_irq_handler(trapframe_t *frame) {
+    int loops;
+
+    serial_stat.irqs++;
+    COUNTER_INC(COUNTER_SERIAL_IRQS);
+
+    for (loops = 0; loops < SERIAL_IRQ_LOOPS; loops++) {
+        unsigned char iir = SERIAL_INB(UART_IIR);
+
+        if (iir & UART_IIR_NONE) {
+            break;
+        }
+
+        switch (iir & UART_IIR_ID_MASK) {
+            case UART_IIR_RLS:
+            case UART_IIR_RDA:
+            case UART_IIR_TIMEOUT:
+                serial_rx_drain();
+                break;
+
+            case UART_IIR_THRE:
+                serial_tx_fill();
+                break;
+
+            case UART_IIR_MSR:
+            default:
+                // Reading the modem status clears the interrupt
+                SERIAL_INB(UART_MSR);
+                break;
+        }
+    }
+}
+
+/**
+ * Programs COM1 for SERIAL_BAUD 8N1 with FIFOs and registers the serial
+ * interrupt handler
+ *
+ * If no UART answers at COM1, serial output is discarded.
+ */
+void serial_init(void) {
+    unsigned int divisor = UART_CLOCK / SERIAL_BAUD;
+
+    kernel_log_info("Initializing serial port at %u baud", SERIAL_BAUD);
+
+    ring_init(&rx_ring);
+
+    // A UART has a scratch register that holds what is written to it
+    SERIAL_OUTB(UART_SCR, 0x5A);
+    if (SERIAL_INB(UART_SCR) != 0x5A) {
+        kernel_log_warn("serial: no UART found at 0x%x", SERIAL_COM1);
+        return;
+    }
+
+    SERIAL_OUTB(UART_IER, 0);
+    SERIAL_OUTB(UART_LCR, UART_LCR_DLAB);
+    SERIAL_OUTB(UART_DLL, divisor & 0xFF);
+    SERIAL_OUTB(UART_DLM, (divisor >> 8) & 0xFF);
+    SERIAL_OUTB(UART_LCR, UART_LCR_8N1);
+    SERIAL_OUTB(UART_FCR, UART_FCR_INIT);
+    SERIAL_OUTB(UART_MCR, UART_MCR_INIT);
+
+    // Discard anything received before now
+    while (SERIAL_INB(UART_LSR) & UART_LSR_DR) {
+        SERIAL_INB(UART_RBR);
+    }
+
+    uart_present = true;
+    serial_start_tick = timer_ticks();
+
+    interrupts_irq_register(IRQ_COM1, serial_irq_handler);
+    uart_ier = UART_IER_RDA | UART_IER_RLS;
+    SERIAL_OUTB(UART_IER, uart_ier);
+}
+
+/**
+ * Indicates if a UART was found at COM1
+ */
+bool serial_present(void) {
+    return uart_present;
+}
+
+/**
+ * Queues bytes for transmission
+ *
+ * New-lines are sent as CR LF. Never waits for the line: bytes that do
+ * not fit in the transmit ring are dropped and counted. May be called
+ * from any context.
+ *
+ * @param buf - bytes to send
+ * @param len - number of bytes to send
+ * @return number of bytes from buf queued
+ */
+int serial_write(const char *buf, int len) {
+    unsigned int flags;
+    unsigned int head;
+    int count;
+
+    if (!uart_present || len <= 0) {
+        return 0;
+    }
+
+    flags = interrupts_save();
+    head = tx_head;
+
+    for (count = 0; count < len; count++) {
+        char c = buf[count];
+
+        if (head - tx_tail + (c == '\n' ? 2 : 1) > SERIAL_TX_SIZE) {
+            break;
+        }
+        if (c == '\n') {
+            tx_buf[head++ & (SERIAL_TX_SIZE - 1)] = '\r';
+        }
+        tx_buf[head++ & (SERIAL_TX_SIZE - 1)] = c;
+    }
+    tx_head = head;
+
+    if (count < len) {
+        serial_stat.tx_drops += len - count;
+        COUNTER_ADD(COUNTER_SERIAL_TX_DROPS, len - count);
+    }
+
+    // Start the transmitter if it is idle; otherwise THRE will refill it
+    serial_tx_fill();
+
+    interrupts_restore(flags);
+    return count;
+}
+
+/**
+ * Sends everything in the transmit ring by polling the UART
+ *
+ * For paths that run with interrupts disabled, such as a panic, where
+ * the THRE interrupt will not come.
+ */
+void serial_flush(void) {
+    unsigned int flags = interrupts_save();
+    int spins = 0;
+
+    while (uart_present && tx_tail != tx_head && spins < SERIAL_FLUSH_SPINS) {
+        if (SERIAL_INB(UART_LSR) & UART_LSR_THRE) {
+            serial_tx_fill();
+            spins = 0;
+        } else {
+            spins++;
+        }
+    }
+
+    interrupts_restore(flags);
+}
+
+/**
+ * Copies the serial port statistics
+ *
+ * @param stats - where to copy the statistics to
+ */
+void serial_stats(serial_stats_t *stats) {
+    unsigned int flags = interrupts_save();
+    *stats = serial_stat;
+    interrupts_restore(flags);
+}
+
+/**
+ * Prints the serial port statistics and transmit throughput to the host
+ */
+void serial_dump(void) {
+    serial_stats_t stats;
+    unsigned int ticks = timer_ticks() - serial_start_tick;
+    unsigned int rate = timer_rate();
+    unsigned int secs = (rate && ticks >= rate) ? ticks / rate : 1;
+
+    if (!uart_present) {
+        kernel_host_printf("serial: no UART\n");
+        return;
+    }
+
+    serial_stats(&stats);
+    kernel_host_printf("serial: tx %u bytes (%u B/s), %u dropped, %u bursts (%u bytes each)\n",
+                       stats.tx_bytes, stats.tx_bytes / secs, stats.tx_drops, stats.tx_bursts,
+                       stats.tx_bursts ? stats.tx_bytes / stats.tx_bursts : 0);
+    kernel_host_printf("serial: rx %u bytes, %u dropped, %u overruns; %u interrupts\n",
+                       stats.rx_bytes, stats.rx_drops, stats.rx_overruns, stats.irqs);
+}
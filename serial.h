@@ -0,0 +1,45 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Serial Port (16550 UART) Functions
+ */
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stdbool.h>
+
+// I/O base of COM1
+#define SERIAL_COM1 0x3F8
+
+// Line rate
+#ifndef SERIAL_BAUD
+#define SERIAL_BAUD 115200
+#endif
+
+// Bytes the transmit ring can hold (must be a power of two)
+#ifndef SERIAL_TX_SIZE
+#define SERIAL_TX_SIZE 4096
+#endif
+
+/**
+ * Serial port statistics
+ */
+typedef struct serial_stats {
+    unsigned int tx_bytes;      // bytes written to the transmitter
+    unsigned int tx_drops;      // bytes dropped because the transmit ring was full
+    unsigned int tx_bursts;     // transmit FIFO refills
+    unsigned int rx_bytes;      // bytes received
+    unsigned int rx_drops;      // bytes dropped because the receive ring was full
+    unsigned int rx_overruns;   // bytes lost in the UART before they were read
+    unsigned int irqs;          // serial interrupts taken
+} serial_stats_t;
+
+void serial_init(void);
+bool serial_present(void);
+int serial_write(const char *buf, int len);
+void serial_flush(void);
+void serial_stats(serial_stats_t *stats);
+void serial_dump(void);
+
+#endif
@@ -0,0 +1,234 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Slab and Arena Allocators
+ *
+ * Each frame given to a cache starts with a pointer back to the cache, so
+ * slab_free() can find the cache of any object from its address alone.
+ */
+#include <stdbool.h>
+
+#include "frame.h"
+#include "interrupts.h"
+#include "kernel.h"
+#include "kernel_log.h"
+#include "slab.h"
+
+// Alignment of every object and arena allocation
+#define SLAB_ALIGN 8
+#define SLAB_ROUND(size) (((size) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1))
+
+// Bytes at the start of each frame holding the pointer back to its cache
+#define SLAB_HEADER ((int)SLAB_ROUND(sizeof(slab_cache_t *)))
+
+// Largest object a cache can hold: one per frame, after the header
+#define SLAB_OBJ_MAX (FRAME_SIZE - SLAB_HEADER)
+
+// Size classes served by slab_kalloc()
+#define SLAB_CLASSES 6
+static const int slab_class_sizes[SLAB_CLASSES] = { 16, 32, 64, 128, 256, 512 };
+static const char *slab_class_names[SLAB_CLASSES] = {
+    "kalloc-16", "kalloc-32", "kalloc-64", "kalloc-128", "kalloc-256", "kalloc-512"
+};
+
+/**
+ * Global variables in this file scope
+ */
+static slab_cache_t slab_classes[SLAB_CLASSES];
+static slab_cache_t *slab_caches = 0;   // all registered caches
+
+/**
+ * Initializes the size class caches used by slab_kalloc()
+ */
+void slab_init(void) {
+    kernel_log_info("Initializing slab allocator");
+
+    for (int i = 0; i < SLAB_CLASSES; i++) {
+        slab_cache_init(&slab_classes[i], slab_class_names[i], slab_class_sizes[i]);
+    }
+}
+
+/**
+ * Initializes an empty cache of fixed-size objects
+ *
+ * No memory is taken until the first allocation. Objects larger than
+ * SLAB_OBJ_MAX do not fit in a frame and are refused.
+ *
+ * @param cache - the cache to initialize
+ * @param name - name shown by slab_dump()
+ * @param obj_size - size of each object in bytes
+ * @return false if obj_size is too large (the cache is left unusable)
+ */
+bool slab_cache_init(slab_cache_t *cache, const char *name, int obj_size) {
+    if (obj_size < (int)sizeof(void *)) {
+        obj_size = sizeof(void *);
+    }
+    if (obj_size > SLAB_OBJ_MAX) {
+        kernel_log_error("slab: %s objects of %d bytes do not fit in a frame", name, obj_size);
+        cache->name = name;
+        cache->obj_size = 0;
+        cache->free_list = 0;
+        return false;
+    }
+
+    cache->name = name;
+    cache->obj_size = SLAB_ROUND(obj_size);
+    cache->free_list = 0;
+    cache->in_use = 0;
+    cache->high_water = 0;
+    cache->total = 0;
+    cache->frames = 0;
+
+    cache->next = slab_caches;
+    slab_caches = cache;
+    return true;
+}
+
+/**
+ * Adds a new frame of objects to a cache's free list
+ *
+ * @return false if no frame could be allocated or the cache was refused
+ *         by slab_cache_init()
+ */
+static bool slab_grow(slab_cache_t *cache) {
+    char *frame;
+
+    if (cache->obj_size <= 0 || cache->obj_size > SLAB_OBJ_MAX) {
+        return false;
+    }
+
+    frame = (char *)(unsigned long)frame_alloc();
+    if (!frame) {
+        return false;
+    }
+
+    *(slab_cache_t **)frame = cache;
+
+    for (char *obj = frame + SLAB_HEADER;
+         obj + cache->obj_size <= frame + FRAME_SIZE;
+         obj += cache->obj_size) {
+        *(void **)obj = cache->free_list;
+        cache->free_list = obj;
+        cache->total++;
+    }
+    cache->frames++;
+
+    return true;
+}
+
+/**
+ * Allocates an object from a cache
+ *
+ * @param cache - the cache to allocate from
+ * @return the object, or 0 if no memory is available
+ */
+void *slab_alloc(slab_cache_t *cache) {
+    unsigned int flags = interrupts_save();
+    void *obj = 0;
+
+    if (cache->free_list || slab_grow(cache)) {
+        obj = cache->free_list;
+        cache->free_list = *(void **)obj;
+
+        cache->in_use++;
+        if (cache->in_use > cache->high_water) {
+            cache->high_water = cache->in_use;
+        }
+    }
+
+    interrupts_restore(flags);
+    return obj;
+}
+
+/**
+ * Returns an object to the cache it was allocated from
+ * @param obj - object returned by slab_alloc or slab_kalloc
+ */
+void slab_free(void *obj) {
+    if (!obj) {
+        return;
+    }
+
+    unsigned int flags = interrupts_save();
+    slab_cache_t *cache = *(slab_cache_t **)((unsigned long)obj & ~(FRAME_SIZE - 1));
+
+    *(void **)obj = cache->free_list;
+    cache->free_list = obj;
+    cache->in_use--;
+
+    interrupts_restore(flags);
+}
+
+/**
+ * Allocates memory from the smallest size class that fits
+ *
+ * Free the memory with slab_free().
+ *
+ * @param size - number of bytes needed
+ * @return the memory, or 0 if size is too large or no memory is available
+ */
+void *slab_kalloc(int size) {
+    for (int i = 0; i < SLAB_CLASSES; i++) {
+        if (size <= slab_class_sizes[i]) {
+            return slab_alloc(&slab_classes[i]);
+        }
+    }
+
+    kernel_log_error("slab: no size class for %d bytes", size);
+    return 0;
+}
+
+/**
+ * Logs the occupancy of every cache
+ */
+void slab_dump(void) {
+    for (slab_cache_t *cache = slab_caches; cache; cache = cache->next) {
+        kernel_log_info("slab: %-12s size %4d in use %5d high %5d total %5d frames %3d",
+                        cache->name, cache->obj_size, cache->in_use,
+                        cache->high_water, cache->total, cache->frames);
+    }
+}
+
+/**
+ * Initializes an arena over a block of memory
+ *
+ * @param arena - the arena to initialize
+ * @param base - memory for the arena to hand out
+ * @param size - size of the memory in bytes
+ */
+void arena_init(arena_t *arena, void *base, int size) {
+    arena->base = base;
+    arena->size = size;
+    arena->used = 0;
+    arena->high_water = 0;
+}
+
+/**
+ * Allocates memory from an arena
+ *
+ * @param arena - the arena to allocate from
+ * @param size - number of bytes needed
+ * @return the memory, or 0 if the arena is full
+ */
+void *arena_alloc(arena_t *arena, int size) {
+    int used = SLAB_ROUND(arena->used);
+
+    if (size < 0 || used + size > arena->size) {
+        return 0;
+    }
+
+    arena->used = used + size;
+    if (arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+    }
+    return arena->base + used;
+}
+
+/**
+ * Releases everything allocated from an arena
+ * @param arena - the arena to reset
+ */
+void arena_reset(arena_t *arena) {
+    arena->used = 0;
+}
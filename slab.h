@@ -0,0 +1,53 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Slab and Arena Allocators
+ */
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stdbool.h>
+
+/**
+ * A cache of fixed-size objects
+ *
+ * Objects are carved out of whole frames. Free objects are kept on an
+ * intrusive singly linked list, so allocating and freeing are O(1).
+ */
+typedef struct slab_cache {
+    const char *name;
+    int obj_size;
+    void *free_list;            // first free object
+    int in_use;                 // objects currently allocated
+    int high_water;             // most objects allocated at once
+    int total;                  // objects carved out of frames so far
+    int frames;                 // frames backing the cache
+    struct slab_cache *next;    // next registered cache
+} slab_cache_t;
+
+/**
+ * A bump-pointer arena for short-lived scratch allocations
+ *
+ * Memory is released all at once with arena_reset().
+ */
+typedef struct arena {
+    char *base;
+    int size;
+    int used;
+    int high_water;
+} arena_t;
+
+void slab_init(void);
+bool slab_cache_init(slab_cache_t *cache, const char *name, int obj_size);
+void *slab_alloc(slab_cache_t *cache);
+void slab_free(void *obj);
+
+void *slab_kalloc(int size);
+void slab_dump(void);
+
+void arena_init(arena_t *arena, void *base, int size);
+void *arena_alloc(arena_t *arena, int size);
+void arena_reset(arena_t *arena);
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Status Field Widget
+ */
+#include <spede/stdarg.h>
+
+#include "fmt.h"
+#include "interrupts.h"
+#include "status.h"
+#include "vga.h"
+#include "vga_ext.h"
+
+/**
+ * Initializes a status field and draws it blank
+ *
+ * The width is clipped to the end of the row.
+ *
+ * @param field field to initialize
+ * @param row the row position (0 to VGA_HEIGHT-1)
+ * @param col the column position (0 to VGA_WIDTH-1)
+ * @param width number of characters in the field
+ * @param bg background color
+ * @param fg foreground color
+ */
+void status_field_init(status_field_t *field, int row, int col, int width, int bg, int fg) {
+    if (width > VGA_WIDTH - col) {
+        width = VGA_WIDTH - col;
+    }
+
+    field->row = row;
+    field->col = col;
+    field->width = width;
+    field->bg = bg;
+    field->fg = fg;
+    field->console = vga_console_output();
+
+    for (int i = 0; i < width; i++) {
+        field->text[i] = ' ';
+    }
+    vga_fill_rect(row, col, 1, width, bg, fg, ' ');
+}
+
+/**
+ * Formatter sink state: the field, the next position in it, and what to
+ * put back when the update is done
+ */
+typedef struct status_cursor {
+    status_field_t *field;
+    int pos;
+    int written;
+    int console;                // console output was directed to before
+    unsigned int flags;
+} status_cursor_t;
+
+/**
+ * Starts an update: directs output to the field's console
+ *
+ * Interrupts stay disabled until status_field_finish() so another task
+ * cannot redirect output in between.
+ */
+static void status_field_start(status_cursor_t *cur, status_field_t *field) {
+    cur->field = field;
+    cur->pos = 0;
+    cur->written = 0;
+    cur->flags = interrupts_save();
+    cur->console = vga_console_select(field->console);
+}
+
+/**
+ * Writes characters into a field from the cursor position, only touching
+ * the cells whose character changed
+ */
+static void status_field_sink(void *ctx, const char *buf, int len) {
+    status_cursor_t *cur = ctx;
+    status_field_t *field = cur->field;
+
+    for (int i = 0; i < len && cur->pos < field->width; i++, cur->pos++) {
+        if (buf[i] != field->text[cur->pos]) {
+            vga_putc_at(field->row, field->col + cur->pos, field->bg, field->fg, buf[i]);
+            field->text[cur->pos] = buf[i];
+            cur->written++;
+        }
+    }
+}
+
+/**
+ * Pads the rest of a field with spaces and ends the update
+ */
+static int status_field_finish(status_cursor_t *cur) {
+    while (cur->pos < cur->field->width) {
+        status_field_sink(cur, " ", 1);
+    }
+    vga_console_select(cur->console);
+    interrupts_restore(cur->flags);
+    return cur->written;
+}
+
+/**
+ * Updates the text of a status field
+ *
+ * Text longer than the field is cut off and shorter text is padded with
+ * spaces. Only the characters that differ from what is on screen are
+ * written.
+ *
+ * @param field field to update
+ * @param text new text
+ * @return number of characters written to the screen
+ */
+int status_field_set(status_field_t *field, const char *text) {
+    status_cursor_t cur;
+    int len = 0;
+
+    while (text[len] != '\0' && len < field->width) {
+        len++;
+    }
+    status_field_start(&cur, field);
+    status_field_sink(&cur, text, len);
+    return status_field_finish(&cur);
+}
+
+/**
+ * Updates the text of a status field from a string format
+ *
+ * The text is formatted straight into the field, with the same rules as
+ * status_field_set().
+ *
+ * @param field field to update
+ * @param fmt string format
+ * @param ... arguments for the string format
+ * @return number of characters written to the screen
+ */
+int status_field_printf(status_field_t *field, const char *fmt, ...) {
+    status_cursor_t cur;
+    va_list args;
+
+    status_field_start(&cur, field);
+    va_start(args, fmt);
+    fmt_vformat(status_field_sink, &cur, fmt, args);
+    va_end(args);
+    return status_field_finish(&cur);
+}
+
+/**
+ * Forgets what a status field last drew, so the next update rewrites
+ * every cell of it
+ *
+ * Call after anything else has drawn over the field.
+ *
+ * @param field field to invalidate
+ */
+void status_field_invalidate(status_field_t *field) {
+    for (int i = 0; i < field->width; i++) {
+        field->text[i] = '\0';
+    }
+}
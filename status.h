@@ -0,0 +1,35 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Status Field Widget
+ */
+#ifndef STATUS_H
+#define STATUS_H
+
+#include "vga.h"
+
+/**
+ * A fixed-width text field at a pinned screen position
+ *
+ * The field remembers what it last drew, so updating it only rewrites the
+ * cells whose character changed. It is drawn on the console that was
+ * receiving output when it was initialized, whichever console output is
+ * directed to when it is updated.
+ */
+typedef struct status_field {
+    int row;
+    int col;
+    int width;
+    int bg;
+    int fg;
+    int console;                // virtual console the field is drawn on
+    char text[VGA_WIDTH];       // characters currently on screen
+} status_field_t;
+
+void status_field_init(status_field_t *field, int row, int col, int width, int bg, int fg);
+int status_field_set(status_field_t *field, const char *text);
+int status_field_printf(status_field_t *field, const char *fmt, ...);
+void status_field_invalidate(status_field_t *field);
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Timer (PIT) Functions
+ */
+#include "counters.h"
+#include "interrupts.h"
+#include "io.h"
+#include "kernel.h"
+#include "kernel_log.h"
+#include "prof.h"
+#include "sched.h"
+#include "timer.h"
+
+// PIT ports
+#define PIT_PORT_CH0        0x40
+#define PIT_PORT_CMD        0x43
+
+// Channel 0, low byte then high byte, mode 2 (rate generator), binary
+#define PIT_CMD_CH0_RATE    0x34
+
+// PIT input clock in Hz
+#define PIT_FREQUENCY       1193182
+
+/**
+ * Global variables in this file scope
+ */
+static volatile unsigned int timer_tick_count = 0;
+static unsigned int timer_hz = 0;
+
+/**
+ * Timer interrupt handler
+ *
+ * Counts the tick, samples the interrupted code for the profiler and lets
+ * the scheduler account for the running task.
+ */
+static void timer_irq_handler(trapframe_t *frame) {
+    timer_tick_count++;
+    COUNTER_INC(COUNTER_TIMER_TICKS);
+    prof_sample(frame);
+    sched_tick();
+}
+
+/**
+ * Programs PIT channel 0 to interrupt at the given rate and registers the
+ * timer interrupt handler
+ *
+ * @param hz - interrupts per second (19 to 1193182)
+ */
+void timer_init(unsigned int hz) {
+    unsigned int divisor;
+
+    if (hz == 0) {
+        hz = TIMER_HZ;
+    }
+
+    // A divisor of 0 is treated by the PIT as 65536
+    divisor = PIT_FREQUENCY / hz;
+    if (divisor < 1) {
+        divisor = 1;
+    } else if (divisor > 0xFFFF) {
+        divisor = 0xFFFF;
+    }
+    timer_hz = PIT_FREQUENCY / divisor;
+
+    kernel_log_info("Initializing timer at %u Hz", timer_hz);
+
+    outportb(PIT_PORT_CMD, PIT_CMD_CH0_RATE);
+    outportb(PIT_PORT_CH0, divisor & 0xFF);
+    outportb(PIT_PORT_CH0, (divisor >> 8) & 0xFF);
+
+    interrupts_irq_register(IRQ_TIMER, timer_irq_handler);
+}
+
+/**
+ * Returns the number of timer interrupts since the timer was initialized
+ */
+unsigned int timer_ticks(void) {
+    return timer_tick_count;
+}
+
+/**
+ * Returns the actual timer interrupt rate in Hz (after divisor rounding)
+ */
+unsigned int timer_rate(void) {
+    return timer_hz;
+}
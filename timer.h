@@ -0,0 +1,19 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Timer (PIT) Functions
+ */
+#ifndef TIMER_H
+#define TIMER_H
+
+// Default timer interrupt rate
+#ifndef TIMER_HZ
+#define TIMER_HZ 100
+#endif
+
+void timer_init(unsigned int hz);
+unsigned int timer_ticks(void);
+unsigned int timer_rate(void);
+
+#endif
@@ -0,0 +1,82 @@
+#!/bin/sh
+#
+# CPE/CSC 159 - Operating System Pragmatics
+# California State University, Sacramento
+#
+# Post-link step: generates the kernel symbol table (see ksym.h) from a
+# linked kernel image.
+#
+# Usage:
+#   tools/ksymgen.sh kernel.elf > ksyms.c
+#
+# Then compile ksyms.c and link the kernel again with ksyms.o as the last
+# object. ksyms.c holds only read-only data, so the text addresses of the
+# second link match the first. Set NM to use a cross toolchain's nm.
+
+set -e
+
+NM=${NM:-nm}
+
+if [ $# -ne 1 ]; then
+    echo "usage: $0 kernel.elf" >&2
+    exit 1
+fi
+
+# nm -n sorts by address; keep text symbols and find where the text ends
+# (the end of the last sized text symbol, or etext if the linker kept it)
+$NM -n -S "$1" | awk '
+    function hex(s,    i, v) {
+        v = 0
+        s = tolower(s)
+        for (i = 1; i <= length(s); i++) {
+            v = v * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+        }
+        return v
+    }
+    BEGIN { n = 0; end = 0; etext = 0 }
+    { type = ""; name = ""; size = "" }
+    NF == 3 { type = $2; name = $3 }
+    NF == 4 { type = $3; name = $4; size = $2 }
+    type ~ /^[Tt]$/ && name !~ /^\./ {
+        addr[n] = $1; names[n] = name; n++
+        if (size != "" && hex($1) + hex(size) > end) {
+            end = hex($1) + hex(size)
+        }
+    }
+    name == "etext" || name == "_etext" {
+        etext = hex($1)
+    }
+    END {
+        if (n == 0) {
+            print "ksymgen: no text symbols found" > "/dev/stderr"
+            exit 1
+        }
+        if (etext) {
+            end = etext
+        }
+        if (!end) {
+            print "ksymgen: cannot find the end of the text" > "/dev/stderr"
+            exit 1
+        }
+
+        print "/* Generated by tools/ksymgen.sh - do not edit */"
+        print "#include \"ksym.h\""
+        print ""
+        printf "const unsigned int ksym_count = %d;\n", n
+        printf "const unsigned int ksym_text_end = 0x%08x;\n", end
+        print ""
+        print "const ksym_t ksym_table[] = {"
+        off = 0
+        for (i = 0; i < n; i++) {
+            printf "    { 0x%s, %d },\t// %s\n", addr[i], off, names[i]
+            off += length(names[i]) + 1
+        }
+        print "};"
+        print ""
+        print "const char ksym_names[] ="
+        for (i = 0; i < n; i++) {
+            printf "    \"%s\\0\"\n", names[i]
+        }
+        print "    ;"
+    }
+'
@@ -0,0 +1,168 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Host tool: decodes a trace ring dump into time-ordered text
+ *
+ * Reads the host console output of trace_dump() on stdin; all lines that
+ * are not trace records are ignored. Build and run on the host with:
+ *   gcc -o trace_decode tools/trace_decode.c ksym.c ksyms.c
+ *   ./trace_decode < console.log
+ *
+ * ksyms.c is the symbol table generated by tools/ksymgen.sh for the kernel
+ * that produced the trace. Without it, code addresses are printed in hex.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ksym.h"
+#include "../trace.h"
+
+#define TRACE_EVENT_FORMAT(id, fmt) [id] = fmt,
+static const char *trace_event_formats[TRACE_EVENT_COUNT] = {
+    TRACE_EVENTS(TRACE_EVENT_FORMAT)
+};
+
+/**
+ * A record read from the dump, with the number of records that were
+ * overwritten just before it in sequence order
+ */
+typedef struct decoded {
+    trace_record_t rec;
+    unsigned int lost;
+} decoded_t;
+
+/**
+ * Prints a record's arguments using its event format
+ *
+ * Conversions are handed to printf one at a time, except %pS, which
+ * prints a code address as symbol+offset.
+ */
+static void print_event(const char *fmt, const unsigned int *args) {
+    int arg = 0;
+
+    while (*fmt) {
+        char spec[16];
+        size_t len;
+
+        if (*fmt != '%') {
+            putchar(*fmt++);
+            continue;
+        }
+
+        if (fmt[1] == '%') {
+            putchar('%');
+            fmt += 2;
+            continue;
+        }
+
+        if (strncmp(fmt, "%pS", 3) == 0) {
+            unsigned int offset;
+            const char *name = ksym_lookup(args[arg], &offset);
+
+            if (name) {
+                printf("%s+0x%x", name, offset);
+            } else {
+                printf("0x%08x", args[arg]);
+            }
+            arg++;
+            fmt += 3;
+            continue;
+        }
+
+        // Flags, width and length up to the conversion character
+        len = strcspn(fmt + 1, "diouxXcs") + 2;
+        if (len >= sizeof(spec) || fmt[len - 1] == '\0' || arg >= 4) {
+            fputs(fmt, stdout);
+            return;
+        }
+        memcpy(spec, fmt, len);
+        spec[len] = '\0';
+        printf(spec, args[arg++]);
+        fmt += len;
+    }
+}
+
+/**
+ * Orders records by sequence number
+ */
+static int seq_compare(const void *a, const void *b) {
+    const trace_record_t *ra = &((const decoded_t *)a)->rec;
+    const trace_record_t *rb = &((const decoded_t *)b)->rec;
+
+    return (ra->seq < rb->seq) ? -1 : (ra->seq > rb->seq);
+}
+
+/**
+ * Orders records by time stamp, then by sequence number
+ */
+static int record_compare(const void *a, const void *b) {
+    const trace_record_t *ra = &((const decoded_t *)a)->rec;
+    const trace_record_t *rb = &((const decoded_t *)b)->rec;
+
+    if (ra->tsc != rb->tsc) {
+        return (ra->tsc < rb->tsc) ? -1 : 1;
+    }
+    return seq_compare(a, b);
+}
+
+int main(void) {
+    decoded_t *recs = NULL;
+    size_t count = 0;
+    size_t size = 0;
+    char line[256];
+
+    while (fgets(line, sizeof(line), stdin)) {
+        trace_record_t rec;
+        char *p = strstr(line, TRACE_DUMP_PREFIX " ");
+
+        if (!p || sscanf(p + strlen(TRACE_DUMP_PREFIX), "%x %llx %x %x %x %x %x",
+                         &rec.seq, &rec.tsc, &rec.event, &rec.args[0],
+                         &rec.args[1], &rec.args[2], &rec.args[3]) != 7) {
+            continue;
+        }
+
+        if (count == size) {
+            size = size ? size * 2 : 1024;
+            recs = realloc(recs, size * sizeof(*recs));
+            if (!recs) {
+                perror("trace_decode");
+                return 1;
+            }
+        }
+        recs[count].rec = rec;
+        recs[count].lost = 0;
+        count++;
+    }
+
+    // Gaps in the sequence numbers mean records were overwritten; they are
+    // found in sequence order, before the records are put in time order
+    qsort(recs, count, sizeof(*recs), seq_compare);
+    for (size_t i = 1; i < count; i++) {
+        recs[i].lost = recs[i].rec.seq - recs[i - 1].rec.seq - 1;
+    }
+
+    qsort(recs, count, sizeof(*recs), record_compare);
+
+    for (size_t i = 0; i < count; i++) {
+        trace_record_t *rec = &recs[i].rec;
+        unsigned long long delta = i ? rec->tsc - recs[i - 1].rec.tsc : 0;
+
+        if (recs[i].lost) {
+            printf("--- %u records lost ---\n", recs[i].lost);
+        }
+
+        printf("%16llu +%-10llu ", rec->tsc, delta);
+        if (rec->event < TRACE_EVENT_COUNT) {
+            print_event(trace_event_formats[rec->event], rec->args);
+        } else {
+            printf("unknown event %u: 0x%x 0x%x 0x%x 0x%x", rec->event,
+                   rec->args[0], rec->args[1], rec->args[2], rec->args[3]);
+        }
+        printf("\n");
+    }
+
+    free(recs);
+    return 0;
+}
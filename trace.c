@@ -0,0 +1,73 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Binary event tracing
+ */
+#include "interrupts.h"
+#include "kernel_log.h"
+#include "serial.h"
+#include "trace.h"
+
+// Records printed between waits for the serial port to catch up; each
+// line is at most 80 bytes, well inside SERIAL_TX_SIZE
+#define TRACE_DUMP_BATCH 32
+
+// Trace ring; trace_seq counts every record ever written
+static trace_record_t trace_ring[TRACE_RING_RECORDS];
+static volatile unsigned int trace_seq = 0;
+
+/**
+ * Records a trace event in the trace ring, overwriting the oldest record
+ * when the ring is full
+ *
+ * @param event - the trace event (trace_event_t)
+ * @param a0 - a3 - event arguments, as used by the event's format string
+ */
+void trace_event(unsigned int event, unsigned int a0, unsigned int a1,
+                 unsigned int a2, unsigned int a3) {
+    // The time stamp is taken along with the sequence number so an
+    // interrupt in between cannot give a later record an earlier time
+    unsigned int flags = interrupts_save();
+    unsigned int seq = trace_seq++;
+    unsigned long long tsc = trace_rdtsc();
+    interrupts_restore(flags);
+
+    trace_record_t *rec = &trace_ring[seq & (TRACE_RING_RECORDS - 1)];
+    rec->tsc = tsc;
+    rec->seq = seq;
+    rec->event = event;
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+    rec->args[2] = a2;
+    rec->args[3] = a3;
+}
+
+/**
+ * Prints the trace ring to the host and the serial port, oldest record
+ * first
+ *
+ * Each record is printed as one line of hex fields:
+ *   TRACE <seq> <tsc> <event> <a0> <a1> <a2> <a3>
+ * which tools/trace_decode turns back into text.
+ *
+ * The serial transmit ring holds far fewer lines than the trace ring, so
+ * it is sent out every TRACE_DUMP_BATCH records for a console capture to
+ * get them all.
+ */
+void trace_dump(void) {
+    unsigned int end = trace_seq;
+    unsigned int start = (end > TRACE_RING_RECORDS) ? end - TRACE_RING_RECORDS : 0;
+
+    for (unsigned int seq = start; seq != end; seq++) {
+        trace_record_t *rec = &trace_ring[seq & (TRACE_RING_RECORDS - 1)];
+
+        kernel_host_printf("%s %x %x%08x %x %x %x %x %x\n", TRACE_DUMP_PREFIX, rec->seq,
+                           (unsigned int)(rec->tsc >> 32), (unsigned int)rec->tsc, rec->event,
+                           rec->args[0], rec->args[1], rec->args[2], rec->args[3]);
+        if ((seq - start) % TRACE_DUMP_BATCH == TRACE_DUMP_BATCH - 1) {
+            serial_flush();
+        }
+    }
+    serial_flush();
+}
@@ -0,0 +1,68 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Binary event tracing
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+// Number of records in the trace ring (must be a power of two)
+#ifndef TRACE_RING_RECORDS
+#define TRACE_RING_RECORDS 1024
+#endif
+
+/**
+ * Trace events and their format strings
+ *
+ * Only the event ID and its integer arguments are recorded; the format
+ * strings are applied when the ring is dumped or decoded on the host.
+ */
+#define TRACE_EVENTS(X) \
+    X(TRACE_IRQ,            "irq %u at eip %pS") \
+    X(TRACE_KBD_SCANCODE,   "keyboard: scancode 0x%02x") \
+    X(TRACE_VGA_SCROLL,     "vga: scroll, origin %u rows %u-%u") \
+    X(TRACE_LOG_DROP,       "log: message dropped at level %u") \
+    X(TRACE_SCHED_SWITCH,   "sched: switch from task %u to task %u") \
+    X(TRACE_WORKQ_RUN,      "workq: run %pS(%u) after %u cycles")
+
+#define TRACE_EVENT_ID(id, fmt) id,
+typedef enum trace_event {
+    TRACE_EVENTS(TRACE_EVENT_ID)
+    TRACE_EVENT_COUNT
+} trace_event_t;
+
+/**
+ * A single trace record (32 bytes)
+ */
+typedef struct trace_record {
+    unsigned long long tsc;     // time stamp counter when recorded
+    unsigned int seq;           // sequence number, counts up from 0 each boot
+    unsigned int event;         // trace_event_t
+    unsigned int args[4];       // event arguments
+} trace_record_t;
+
+// Line prefix used by trace_dump() and recognized by tools/trace_decode
+#define TRACE_DUMP_PREFIX "TRACE"
+
+/**
+ * Reads the CPU time stamp counter
+ */
+static inline unsigned long long trace_rdtsc(void) {
+    unsigned int lo, hi;
+
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+void trace_event(unsigned int event, unsigned int a0, unsigned int a1,
+                 unsigned int a2, unsigned int a3);
+void trace_dump(void);
+
+#ifdef TRACE_DISABLE
+#define TRACE(event, a0, a1, a2, a3) do { } while (0)
+#else
+#define TRACE(event, a0, a1, a2, a3) trace_event((event), (a0), (a1), (a2), (a3))
+#endif
+
+#endif
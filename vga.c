@@ -1,10 +1,21 @@
 #include <spede/stdarg.h>
 #include <spede/stdio.h>
+#include <spede/string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "bit.h"
+#include "counters.h"
+#include "fmt.h"
+#include "interrupts.h"
 #include "io.h"
 #include "kernel.h"
+#include "kernel_log.h"
+#include "trace.h"
 #include "vga.h"
+#include "vga_ext.h"
 
 /**
  * Forward Declarations
@@ -15,16 +26,343 @@ void vga_cursor_update(void);
  * Global variables in this file scope
  */
 static bool cursor_enabled = false;
-static int current_row = 0;
-static int current_col = 0;
-static int bg_color = VGA_COLOR_BLACK;
-static int fg_color = VGA_COLOR_LIGHT_GREY;
+static bool cursor_deferred = false;
+static int cursor_hw_pos = -1;      // last position written to the CRTC, -1 if unknown
+
+/**
+ * Back buffer (shadow) state
+ *
+ * When the shadow is enabled, every vga_* write goes to a RAM copy of the
+ * screen instead of video memory. The columns touched on each row are
+ * tracked as a [start, end) span so vga_flush() only copies what changed.
+ */
+static bool shadow_enabled = false;
+static bool shadow_autoflush = false;
+
+/**
+ * Scroll ring state
+ *
+ * Text mode has 32 KB of video memory but only displays 4000 bytes of it.
+ * When the ring is enabled, scrolling moves the displayed window down by
+ * reprogramming the CRTC start address instead of copying every line.
+ * Only when the window reaches the end of the console's page of video
+ * memory are the visible lines moved back to the start of the page.
+ */
+static bool ring_enabled = false;
+
+/**
+ * Scrollback state
+ *
+ * Lines scrolled off the top of the screen are kept in a fixed ring of
+ * VGA_SCROLLBACK_LINES lines. While the view is scrolled back, the live
+ * screen is kept in scrollback_live so it can be restored afterwards.
+ */
+#ifndef VGA_SCROLLBACK_LINES
+#define VGA_SCROLLBACK_LINES 256
+#endif
+
+/**
+ * Virtual consoles
+ *
+ * Each console has its own position, colors, scrollback and RAM copy of
+ * the screen, and owns a page of VGA_CONSOLE_CELLS cells of video memory.
+ * Switching consoles points the CRTC start address at the new page and
+ * copies only the cells that changed while the console was hidden.
+ *
+ * The console on screen is written as before: to video memory, or to its
+ * RAM copy when the shadow is enabled. Consoles in the background always
+ * write to their RAM copy and never touch video memory.
+ */
+#ifndef VGA_CONSOLES
+#define VGA_CONSOLES 4
+#endif
+
+// Whole lines in each console's share of 32 KB of video memory
+#define VGA_CONSOLE_CELLS (0x4000 / VGA_CONSOLES / VGA_WIDTH * VGA_WIDTH)
+
+typedef struct vga_console {
+    int row;
+    int col;
+    int bg;
+    int fg;
+    unsigned short cells[VGA_HEIGHT * VGA_WIDTH];   // RAM copy of the screen
+    int dirty_start[VGA_HEIGHT];
+    int dirty_end[VGA_HEIGHT];
+    int page;                   // cell offset of the console's page in video memory
+    int origin;                 // cell offset of row 0 in video memory
+    int pending;                // lines scrolled in RAM but not yet in video memory
+    int scroll_top;             // first row of the scroll region
+    int scroll_bottom;          // last row of the scroll region
+    unsigned short scrollback[VGA_SCROLLBACK_LINES][VGA_WIDTH];
+    unsigned short scrollback_live[VGA_HEIGHT * VGA_WIDTH];
+    int scrollback_head;        // next line in the ring to be written
+    int scrollback_count;       // number of lines held in the ring
+    int scrollback_offset;      // lines the view is scrolled back, 0 when live
+} vga_console_t;
+
+/**
+ * The shell and the work queue task (console switches, scrollback, kernel
+ * commands) both print, so every public function that changes the driver
+ * state does so with interrupts disabled. The calls nest.
+ */
+static vga_console_t consoles[VGA_CONSOLES];
+static vga_console_t *con = &consoles[0];       // console receiving output
+static vga_console_t *active = &consoles[0];    // console on screen
 
 /**
 * to navigate the cursor a value of 4 spaces when the tab is pressed
 */
 #define TAB_STOP 4
 
+/**
+ * Attribute bits within a character cell
+ */
+#define VGA_ATTR_BG_MASK 0xF000
+#define VGA_ATTR_FG_MASK 0x0F00
+#define VGA_ATTR_BG(bg) (((bg) & 0xF) << 12)
+#define VGA_ATTR_FG(fg) (((fg) & 0xF) << 8)
+
+/**
+ * Indicates if a character is handled specially by vga_putc/vga_write
+ * rather than printed: new-line, carriage return, tab, and backspace
+ */
+#define VGA_SPECIAL_CHARS ((1 << '\n') | (1 << '\r') | (1 << '\t') | (1 << '\b'))
+#define VGA_IS_SPECIAL(c) ((c) < 32 && ((VGA_SPECIAL_CHARS >> (c)) & 1))
+
+// Two adjacent cells accessed as one 32-bit word
+typedef unsigned int vga_pair_t __attribute__((may_alias));
+
+/**
+ * Fills a run of cells with the same value
+ *
+ * Stores are done 16 bytes at a time with SSE2 when the target has it,
+ * otherwise two cells at a time, with single-cell stores at the edges.
+ *
+ * @param dst first cell to fill
+ * @param cell cell value (character and attribute)
+ * @param count number of cells to fill
+ */
+static void vga_fill_cells(unsigned short *dst, unsigned short cell, int count) {
+    if (count > 0 && ((unsigned long)dst & 2)) {
+        *dst++ = cell;
+        count--;
+    }
+
+#ifdef __SSE2__
+    __m128i cells = _mm_set1_epi16((short)cell);
+    for (; count >= 8; count -= 8, dst += 8) {
+        _mm_storeu_si128((__m128i *)dst, cells);
+    }
+#endif
+
+    unsigned int pair = ((unsigned int)cell << 16) | cell;
+    vga_pair_t *dst32 = (vga_pair_t *)dst;
+    for (; count >= 2; count -= 2) {
+        *dst32++ = pair;
+    }
+
+    if (count > 0) {
+        *(unsigned short *)dst32 = cell;
+    }
+}
+
+/**
+ * Copies a run of characters into consecutive cells with the given
+ * attribute bits
+ *
+ * @param dst first cell to write
+ * @param attr attribute bits (character bits must be zero)
+ * @param src characters to copy
+ * @param len number of characters to copy
+ */
+static void vga_copy_run(unsigned short *dst, unsigned short attr, const char *src, int len) {
+    for (int i = 0; i < len; i++) {
+        dst[i] = attr | (unsigned char)src[i];
+    }
+}
+
+/**
+ * Rewrites the attribute bits of a run of cells, leaving the characters
+ * (and any attribute bits outside of the mask) unchanged
+ *
+ * @param dst first cell to modify
+ * @param mask attribute bits to replace
+ * @param bits new value for the masked bits
+ * @param count number of cells to modify
+ */
+static void vga_recolor_cells(unsigned short *dst, unsigned short mask, unsigned short bits, int count) {
+    unsigned short keep = ~mask;
+
+    bits &= mask;
+    if (count > 0 && ((unsigned long)dst & 2)) {
+        *dst = (*dst & keep) | bits;
+        dst++;
+        count--;
+    }
+
+#ifdef __SSE2__
+    __m128i keep128 = _mm_set1_epi16((short)keep);
+    __m128i bits128 = _mm_set1_epi16((short)bits);
+    for (; count >= 8; count -= 8, dst += 8) {
+        __m128i cells = _mm_loadu_si128((__m128i *)dst);
+        cells = _mm_or_si128(_mm_and_si128(cells, keep128), bits128);
+        _mm_storeu_si128((__m128i *)dst, cells);
+    }
+#endif
+
+    unsigned int keep32 = ((unsigned int)keep << 16) | keep;
+    unsigned int bits32 = ((unsigned int)bits << 16) | bits;
+    vga_pair_t *dst32 = (vga_pair_t *)dst;
+    for (; count >= 2; count -= 2, dst32++) {
+        *dst32 = (*dst32 & keep32) | bits32;
+    }
+
+    if (count > 0) {
+        dst = (unsigned short *)dst32;
+        *dst = (*dst & keep) | bits;
+    }
+}
+
+/**
+ * Indicates if writes to the output console go to its RAM copy: always for
+ * consoles in the background, and for the console on screen when the
+ * shadow is enabled
+ */
+static bool vga_buffered(void) {
+    return shadow_enabled || con != active;
+}
+
+/**
+ * Returns the cell array for the output console's screen: its RAM copy
+ * when buffered, otherwise video memory
+ */
+static unsigned short *vga_screen(void) {
+    return vga_buffered() ? con->cells : VGA_BASE + con->origin;
+}
+
+/**
+ * Returns the cell array that writes should go to
+ *
+ * If the view is scrolled back, the live screen is restored first so new
+ * output is never written over history.
+ */
+static unsigned short *vga_cells(void) {
+    if (con->scrollback_offset != 0) {
+        vga_scrollback_view(-con->scrollback_offset);
+    }
+    return vga_screen();
+}
+
+/**
+ * Marks columns [start, end) of a row as changed in the shadow buffer
+ *
+ * @param row the row position (0 to VGA_HEIGHT-1)
+ * @param start first column that changed
+ * @param end one past the last column that changed
+ */
+static void vga_mark_dirty(int row, int start, int end) {
+    if (!vga_buffered() || row < 0 || row >= VGA_HEIGHT) {
+        return;
+    }
+    if (start < con->dirty_start[row]) {
+        con->dirty_start[row] = start;
+    }
+    if (end > con->dirty_end[row]) {
+        con->dirty_end[row] = (end > VGA_WIDTH) ? VGA_WIDTH : end;
+    }
+}
+
+/**
+ * Marks cells [start, end) as changed in the shadow buffer, where the
+ * range is a linear cell offset that may span multiple rows
+ *
+ * @param start first cell offset that changed
+ * @param end one past the last cell offset that changed
+ */
+static void vga_mark_dirty_cells(int start, int end) {
+    if (!vga_buffered()) {
+        return;
+    }
+
+    while (start < end) {
+        int row = start / VGA_WIDTH;
+        int row_end = (row + 1) * VGA_WIDTH;
+        int span_end = (end < row_end) ? end : row_end;
+
+        vga_mark_dirty(row, start - row * VGA_WIDTH, span_end - row * VGA_WIDTH);
+        start = span_end;
+    }
+}
+
+/**
+ * Marks every row in the shadow buffer as changed
+ */
+static void vga_mark_all_dirty(void) {
+    vga_mark_dirty_cells(0, VGA_HEIGHT * VGA_WIDTH);
+}
+
+/**
+ * CRTC register access
+ *
+ * All VGA port I/O goes through these two functions: the register index
+ * is written to the address port, then the value is read from or written
+ * to the data port.
+ */
+static void vga_crtc_write(unsigned char reg, unsigned char value) {
+    COUNTER_ADD(COUNTER_VGA_PORT_WRITES, 2);
+    outportb(VGA_PORT_ADDR, reg);
+    outportb(VGA_PORT_DATA, value);
+}
+
+static unsigned char vga_crtc_read(unsigned char reg) {
+    COUNTER_INC(COUNTER_VGA_PORT_WRITES);
+    COUNTER_INC(COUNTER_VGA_PORT_READS);
+    outportb(VGA_PORT_ADDR, reg);
+    return inportb(VGA_PORT_DATA);
+}
+
+/**
+ * Writes the ring origin to the CRTC start address registers
+ *   0x0C Start Address High Register
+ *   0x0D Start Address Low Register
+ *
+ * Does nothing for consoles in the background.
+ */
+static void vga_ring_update(void) {
+    if (con != active) {
+        return;
+    }
+    vga_crtc_write(0x0C, (unsigned char)((con->origin >> 8) & 0xFF));
+    vga_crtc_write(0x0D, (unsigned char)(con->origin & 0xFF));
+}
+
+/**
+ * Moves the displayed window down the ring by the given number of lines
+ *
+ * If the window would run past the end of the console's page, the lines
+ * that remain visible are moved back to the start of the page. When the
+ * console is buffered the whole screen is redrawn from RAM instead, so
+ * video memory never has to be read back.
+ *
+ * @param lines number of lines to move the window by
+ */
+static void vga_ring_advance(int lines) {
+    int origin = con->origin + lines * VGA_WIDTH;
+
+    if (origin + VGA_HEIGHT * VGA_WIDTH > con->page + VGA_CONSOLE_CELLS) {
+        if (vga_buffered()) {
+            vga_mark_all_dirty();
+        } else if (lines < VGA_HEIGHT) {
+            memmove(&VGA_BASE[con->page], &VGA_BASE[origin],
+                    (VGA_HEIGHT - lines) * VGA_WIDTH * sizeof(unsigned short));
+        }
+        origin = con->page;
+    }
+
+    con->origin = origin;
+    vga_ring_update();
+}
+
 /**
  * Initializes the VGA driver and configuration
  *  - Defaults variables
@@ -33,22 +371,44 @@ static int fg_color = VGA_COLOR_LIGHT_GREY;
 void vga_init(void) {
     kernel_log_info("Initializing VGA driver");
 
-    // Clear the screen
-    vga_clear();
+    for (int i = 0; i < VGA_CONSOLES; i++) {
+        con = &consoles[i];
+        con->page = i * VGA_CONSOLE_CELLS;
+        con->origin = con->page;
+        con->bg = VGA_COLOR_BLACK;
+        con->fg = VGA_COLOR_LIGHT_GREY;
+        con->scroll_top = 0;
+        con->scroll_bottom = VGA_HEIGHT - 1;
+        for (int row = 0; row < VGA_HEIGHT; row++) {
+            con->dirty_start[row] = VGA_WIDTH;
+            con->dirty_end[row] = 0;
+        }
+
+        // Clear the screen; consoles in the background are cleared in RAM
+        // and painted the first time they are shown
+        vga_clear();
+    }
+    con = active;
 }
 
 /**
  * Clears the VGA output and sets the background and foreground colors
+ *
+ * Only the scroll region is cleared; lines pinned outside of it are kept.
  */
 void vga_clear(void) {
+    unsigned int flags = interrupts_save();
+    int start = con->scroll_top * VGA_WIDTH;
+    int end = (con->scroll_bottom + 1) * VGA_WIDTH;
+
     // Clear all character data, set the foreground and background colors
-    // Set the cursor position to the top-left corner (0, 0)
-    for (int i = 0; i < VGA_HEIGHT * VGA_WIDTH; ++i) {
-        VGA_BASE[i] = VGA_CHAR(bg_color, fg_color, ' ');
-    }
-    current_row = 0;
-    current_col = 0;
+    // Set the cursor position to the top-left corner of the region
+    vga_fill_cells(&vga_cells()[start], VGA_CHAR(con->bg, con->fg, ' '), end - start);
+    vga_mark_dirty_cells(start, end);
+    con->row = con->scroll_top;
+    con->col = 0;
     vga_cursor_update();
+    interrupts_restore(flags);
 }
 
 /**
@@ -58,10 +418,12 @@ void vga_clear(void) {
  * @param bg background color value
  */
 void vga_clear_bg(int bg) {
-    // Iterate through all VGA memory and set only the background color bits
-    for (int i = 0; i < VGA_HEIGHT * VGA_WIDTH; ++i) {
-        VGA_BASE[i] = (VGA_BASE[i] & 0x0F) | (bg << 4);
-    }
+    unsigned int flags = interrupts_save();
+
+    // Set only the background color bits (high nibble of the attribute byte)
+    vga_recolor_cells(vga_cells(), VGA_ATTR_BG_MASK, VGA_ATTR_BG(bg), VGA_HEIGHT * VGA_WIDTH);
+    vga_mark_all_dirty();
+    interrupts_restore(flags);
 }
 
 /**
@@ -71,16 +433,20 @@ void vga_clear_bg(int bg) {
  * @param fg foreground color value
  */
 void vga_clear_fg(int fg) {
-    // Iterate through all VGA memory and set only the foreground color bits.
-    for (int i = 0; i < VGA_HEIGHT * VGA_WIDTH; ++i) {
-        VGA_BASE[i] = (VGA_BASE[i] & 0xF0) | fg;
-    }
+    unsigned int flags = interrupts_save();
+
+    // Set only the foreground color bits (low nibble of the attribute byte)
+    vga_recolor_cells(vga_cells(), VGA_ATTR_FG_MASK, VGA_ATTR_FG(fg), VGA_HEIGHT * VGA_WIDTH);
+    vga_mark_all_dirty();
+    interrupts_restore(flags);
 }
 
 /**
  * Enables the VGA text mode cursor
  */
 void vga_cursor_enable(void) {
+    unsigned int flags = interrupts_save();
+
     // All operations will consist of writing to the address port which
     // register should be set, followed by writing to the data port the value
     // to set for the specified register
@@ -118,17 +484,19 @@ void vga_cursor_enable(void) {
 
     //Phase 1 code @DevG
     // Set cursor start and end registers to enable cursor
-    outportb(0x3D4, 0x0A);
-    outportb(0x3D5, (inportb(0x3D5) & 0xC0) | 0);
+    vga_crtc_write(0x0A, vga_crtc_read(0x0A) & 0xC0);
     cursor_enabled = true;
-    vga_cursor_update();
-    
+    cursor_hw_pos = -1;
+    vga_cursor_sync();
+    interrupts_restore(flags);
 }
 
 /**
  * Disables the VGA text mode cursor
  */
 void vga_cursor_disable(void) {
+    unsigned int flags = interrupts_save();
+
     // All operations will consist of writing to the address port which
     // register should be set, followed by writing to the data port the value
     // to set for the specified register
@@ -151,9 +519,9 @@ void vga_cursor_disable(void) {
 
     // Phase 1 code @DevG
     // Set cursor start and end registers to disable cursor
-    outportb(VGA_PORT_ADDR, 0x0A);
-    outportb(VGA_PORT_DATA, 0x20);
+    vga_crtc_write(0x0A, 0x20);
     cursor_enabled = false;
+    interrupts_restore(flags);
 }
 
 /**
@@ -190,13 +558,51 @@ void vga_cursor_update(void) {
 
         // Set the VGA Cursor Location Low Register (0x0E)
         //   Should be the most significant byte (0x<00>??)
-    if (cursor_enabled) {
-        unsigned short pos = current_row * VGA_WIDTH + current_col;
-        outportb(VGA_PORT_ADDR, 0x0F);
-        outportb(VGA_PORT_DATA, (unsigned char)(pos & 0xFF));
-        outportb(VGA_PORT_ADDR, 0x0E);
-        outportb(VGA_PORT_DATA, (unsigned char)((pos >> 8) & 0xFF));
-    }    
+    // When deferred, the position is only tracked in software here and
+    // pushed to the registers by vga_cursor_sync()
+    if (cursor_enabled && !cursor_deferred) {
+        vga_cursor_sync();
+    }
+}
+
+/**
+ * Writes the current row/column position to the cursor location registers
+ * if the cursor is enabled
+ *
+ * The registers are skipped entirely if the position has not changed since
+ * the last time it was written.
+ */
+void vga_cursor_sync(void) {
+    unsigned int flags = interrupts_save();
+    unsigned short pos = active->origin + active->row * VGA_WIDTH + active->col;
+
+    if (cursor_enabled && pos != cursor_hw_pos) {
+        COUNTER_INC(COUNTER_VGA_CURSOR_SYNCS);
+        vga_crtc_write(0x0F, (unsigned char)(pos & 0xFF));
+        vga_crtc_write(0x0E, (unsigned char)((pos >> 8) & 0xFF));
+        cursor_hw_pos = pos;
+    }
+    interrupts_restore(flags);
+}
+
+/**
+ * Enables or disables deferred cursor updates
+ *
+ * While deferred, printing only tracks the cursor position in software.
+ * The hardware cursor is moved once at the end of each vga_puts (and so
+ * vga_printf) call or when vga_cursor_sync() is called.
+ *
+ * @param defer true to defer cursor updates, false to update on every write
+ */
+void vga_cursor_defer(bool defer) {
+    unsigned int flags = interrupts_save();
+
+    cursor_deferred = defer;
+
+    if (!defer) {
+        vga_cursor_sync();
+    }
+    interrupts_restore(flags);
 }
 
 /**
@@ -208,10 +614,13 @@ void vga_cursor_update(void) {
  *        will be set to the range boundary (min or max)
  */
 void vga_set_rowcol(int row, int col) {
+    unsigned int flags = interrupts_save();
+
     // Update the text mode cursor (if enabled)
-    current_row = (row >= 0 && row < VGA_HEIGHT) ? row : (row < 0 ? 0 : VGA_HEIGHT - 1);
-    current_col = (col >= 0 && col < VGA_WIDTH) ? col : (col < 0 ? 0 : VGA_WIDTH - 1);
+    con->row = (row >= 0 && row < VGA_HEIGHT) ? row : (row < 0 ? 0 : VGA_HEIGHT - 1);
+    con->col = (col >= 0 && col < VGA_WIDTH) ? col : (col < 0 ? 0 : VGA_WIDTH - 1);
     vga_cursor_update();
+    interrupts_restore(flags);
 }
 
 /**
@@ -219,7 +628,7 @@ void vga_set_rowcol(int row, int col) {
  * @return integer value of the row (between 0 and VGA_HEIGHT-1)
  */
 int vga_get_row(void) {
-    return current_row;
+    return con->row;
 }
 
 /**
@@ -227,7 +636,7 @@ int vga_get_row(void) {
  * @return integer value of the column (between 0 and VGA_WIDTH-1)
  */
 int vga_get_col(void) {
-    return current_col;
+    return con->col;
 }
 
 /**
@@ -239,7 +648,7 @@ int vga_get_col(void) {
  * @param bg - background color
  */
 void vga_set_bg(int bg) {
-    bg_color = bg;
+    con->bg = bg;
 }
 
 /**
@@ -247,7 +656,7 @@ void vga_set_bg(int bg) {
  * @return background color value
  */
 int vga_get_bg(void) {
-    return bg_color;
+    return con->bg;
 }
 
 /**
@@ -259,7 +668,7 @@ int vga_get_bg(void) {
  * @param color - background color
  */
 void vga_set_fg(int fg) {
-    fg_color = fg;
+    con->fg = fg;
 }
 
 /**
@@ -267,7 +676,7 @@ void vga_set_fg(int fg) {
  * @return foreground color value
  */
 int vga_get_fg(void) {
-    return fg_color;
+    return con->fg;
 }
 
 /**
@@ -276,17 +685,20 @@ int vga_get_fg(void) {
  * @param c - Character to print
  */
 void vga_setc(unsigned char c) {
-    unsigned short *vga_buf = VGA_BASE;
-    vga_buf[current_row * VGA_WIDTH + current_col] = VGA_CHAR(bg_color, fg_color, c);
-    current_col++;
-    if (current_col >= VGA_WIDTH) {
-        current_col = 0;
-        current_row++;
-        if (current_row >= VGA_HEIGHT) {
-            current_row = 0;
+    unsigned int flags = interrupts_save();
+    unsigned short *vga_buf = vga_cells();
+    vga_buf[con->row * VGA_WIDTH + con->col] = VGA_CHAR(con->bg, con->fg, c);
+    vga_mark_dirty(con->row, con->col, con->col + 1);
+    con->col++;
+    if (con->col >= VGA_WIDTH) {
+        con->col = 0;
+        con->row++;
+        if (con->row >= VGA_HEIGHT) {
+            con->row = 0;
         }
     }
     vga_cursor_update();
+    interrupts_restore(flags);
 }
 
 /**
@@ -296,7 +708,7 @@ void vga_setc(unsigned char c) {
  *  - Update the row and column positions
  *  - If needed, will wrap from the end of the current line to the
  *    start of the next line
- *  - If the last line is reached, the cursor position will reset to the top-left (0, 0) position
+ *  - If the last line is reached, the screen will scroll up one line
  *  - Special characters are handled as such:
  *    - tab character (\t) prints 'tab_stop' spaces
  *    - backspace (\b) character moves the character back one position,
@@ -307,46 +719,79 @@ void vga_setc(unsigned char c) {
  * @param c - character to print
  */
 void vga_putc(unsigned char c) {
-    unsigned short *vga_buf = VGA_BASE;
-    // Handle scecial characters
-    // Handle end of lines
-    // Wrap-around to the top/left corner
-    // Update the text mode cursor, if enabled
-    switch (c) {
-        case '\n':
-            current_row++;
-            current_col = 0;
-            break;
-        case '\r':
-            current_col = 0;
-            break;
-        case '\t':
-            // Tab character - Move to the next tab stop
-            current_col = (current_col + TAB_STOP) & ~(TAB_STOP - 1);
-            break;
-        case '\b':
-            // Backspace character
-            if (current_col > 0) {
-                current_col--;
-                vga_buf[current_row * VGA_WIDTH + current_col] = VGA_CHAR(bg_color, fg_color, ' ');
+    vga_write((char *)&c, 1);
+}
+
+/**
+ * Prints len characters from a buffer at the current cursor (row/column)
+ * position
+ *
+ * Characters are handled the same as vga_putc, but runs of printable
+ * characters between special characters are copied straight into the row
+ * with the attribute bits computed once. Special characters and wrapping
+ * are only handled at the ends of runs.
+ *
+ * @param buf - characters to print
+ * @param len - number of characters to print
+ */
+void vga_write(const char *buf, int len) {
+    unsigned int flags = interrupts_save();
+    unsigned short attr = VGA_CHAR(con->bg, con->fg, 0);
+    int i = 0;
+
+    while (i < len) {
+        unsigned char c = buf[i];
+
+        if (!VGA_IS_SPECIAL(c)) {
+            // Copy as much of the run as fits on the current row
+            int run = 1;
+            int room = VGA_WIDTH - con->col;
+            while (run < room && i + run < len && !VGA_IS_SPECIAL((unsigned char)buf[i + run])) {
+                run++;
             }
-            break;
-        default:
-            // Print any other character
-            vga_buf[current_row * VGA_WIDTH + current_col] = VGA_CHAR(bg_color, fg_color, c);
-            current_col++;
-            break;
-    }
 
-    // Handle wrapping
-    if (current_col >= VGA_WIDTH) {
-        current_col = 0;
-        current_row++;
-    }
-    if (current_row >= VGA_HEIGHT) {
-        current_row = 0;
+            vga_copy_run(&vga_cells()[con->row * VGA_WIDTH + con->col], attr, &buf[i], run);
+            vga_mark_dirty(con->row, con->col, con->col + run);
+            COUNTER_ADD(COUNTER_VGA_CHARS, run);
+            con->col += run;
+            i += run;
+        } else {
+            // Handle special characters
+            switch (c) {
+                case '\n':
+                    con->row++;
+                    con->col = 0;
+                    break;
+                case '\r':
+                    con->col = 0;
+                    break;
+                case '\t':
+                    // Tab character - Move to the next tab stop
+                    con->col = (con->col + TAB_STOP) & ~(TAB_STOP - 1);
+                    break;
+                case '\b':
+                    // Backspace character
+                    if (con->col > 0) {
+                        con->col--;
+                        vga_cells()[con->row * VGA_WIDTH + con->col] = attr | ' ';
+                        vga_mark_dirty(con->row, con->col, con->col + 1);
+                    }
+                    break;
+            }
+            i++;
+        }
+
+        // Handle wrapping
+        if (con->col >= VGA_WIDTH) {
+            con->col = 0;
+            con->row++;
+        }
+        if (con->row == con->scroll_bottom + 1 || con->row >= VGA_HEIGHT) {
+            vga_scroll();
+        }
     }
     vga_cursor_update();
+    interrupts_restore(flags);
 }
 
 /**
@@ -355,10 +800,59 @@ void vga_putc(unsigned char c) {
  * @param s - string to print
  */
 void vga_puts(char *str) {
-    while (*str != '\0') {
-        vga_putc(*str);
-        str++;
+    unsigned int flags = interrupts_save();
+
+    vga_write(str, strlen(str));
+
+    if (shadow_autoflush) {
+        vga_flush();
+    }
+    vga_cursor_sync();
+    interrupts_restore(flags);
+}
+
+/**
+ * Formatter sink that prints runs at the current cursor position
+ */
+static void vga_fmt_sink(void *ctx, const char *buf, int len) {
+    vga_write(buf, len);
+}
+
+/**
+ * Prints a formatted string on the screen at the current cursor
+ * (row/column) position
+ *
+ * The output is streamed to the screen as it is formatted; no
+ * intermediate buffer is used.
+ *
+ * @param fmt - string format
+ * @param args - arguments for the string format
+ */
+void vga_vprintf(const char *fmt, va_list args) {
+    unsigned int flags = interrupts_save();
+
+    fmt_vformat(vga_fmt_sink, NULL, fmt, args);
+
+    if (shadow_autoflush) {
+        vga_flush();
     }
+    vga_cursor_sync();
+    interrupts_restore(flags);
+}
+
+/**
+ * Prints a formatted string on the screen at the current cursor
+ * (row/column) position
+ *
+ * @param fmt - string format
+ * @param ... - arguments for the string format
+ */
+void vga_printf(const char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    vga_vprintf(fmt, args);
+    va_end(args);
 }
 
 /**
@@ -375,8 +869,11 @@ void vga_puts(char *str) {
  * @param c character to print
  */
 void vga_putc_at(int row, int col, int bg, int fg, unsigned char c) {
-    unsigned short *vga_buf = VGA_BASE;
+    unsigned int flags = interrupts_save();
+    unsigned short *vga_buf = vga_cells();
     vga_buf[row * VGA_WIDTH + col] = VGA_CHAR(bg, fg, c);
+    vga_mark_dirty(row, col, col + 1);
+    interrupts_restore(flags);
 }
 
 /**
@@ -393,31 +890,506 @@ void vga_putc_at(int row, int col, int bg, int fg, unsigned char c) {
  * @param s string to print
  */
 void vga_puts_at(int row, int col, int bg, int fg, char *s) {
-    unsigned short *vga_buf = VGA_BASE;
-    int i = 0;
-    while (s[i] != '\0') {
-        vga_buf[row * VGA_WIDTH + col + i] = VGA_CHAR(bg, fg, s[i]);
-        i++;
+    int start = row * VGA_WIDTH + col;
+    int len = strlen(s);
+    unsigned int flags;
+
+    // The string may continue onto the following rows, but not past the
+    // end of the screen
+    if (start < 0 || start >= VGA_HEIGHT * VGA_WIDTH) {
+        return;
+    }
+    if (start + len > VGA_HEIGHT * VGA_WIDTH) {
+        len = VGA_HEIGHT * VGA_WIDTH - start;
+    }
+
+    flags = interrupts_save();
+    vga_copy_run(&vga_cells()[start], VGA_CHAR(bg, fg, 0), s, len);
+    vga_mark_dirty_cells(start, start + len);
+    interrupts_restore(flags);
+}
+
+/**
+ * Clips a rectangle to the screen
+ *
+ * @return false if nothing of the rectangle is on the screen
+ */
+static bool vga_clip_rect(int *row, int *col, int *height, int *width) {
+    if (*row < 0) {
+        *height += *row;
+        *row = 0;
+    }
+    if (*col < 0) {
+        *width += *col;
+        *col = 0;
+    }
+    if (*row + *height > VGA_HEIGHT) {
+        *height = VGA_HEIGHT - *row;
+    }
+    if (*col + *width > VGA_WIDTH) {
+        *width = VGA_WIDTH - *col;
+    }
+    return *height > 0 && *width > 0;
+}
+
+/**
+ * Fills a rectangular region with a character and colors
+ *
+ * Does not modify the current row or column position
+ * Does not modify the current background or foreground colors
+ *
+ * @param row top row of the region
+ * @param col left column of the region
+ * @param height number of rows in the region
+ * @param width number of columns in the region
+ * @param bg background color
+ * @param fg foreground color
+ * @param c character to fill with
+ */
+void vga_fill_rect(int row, int col, int height, int width, int bg, int fg, unsigned char c) {
+    if (!vga_clip_rect(&row, &col, &height, &width)) {
+        return;
+    }
+
+    unsigned int flags = interrupts_save();
+    unsigned short *vga_buf = vga_cells();
+    unsigned short cell = VGA_CHAR(bg, fg, c);
+
+    // Full-width regions are one contiguous run of cells
+    if (width == VGA_WIDTH) {
+        vga_fill_cells(&vga_buf[row * VGA_WIDTH], cell, height * VGA_WIDTH);
+    } else {
+        for (int r = row; r < row + height; r++) {
+            vga_fill_cells(&vga_buf[r * VGA_WIDTH + col], cell, width);
+        }
+    }
+
+    for (int r = row; r < row + height; r++) {
+        vga_mark_dirty(r, col, col + width);
+    }
+    interrupts_restore(flags);
+}
+
+/**
+ * Changes the colors of a rectangular region without changing the
+ * characters in it
+ *
+ * @param row top row of the region
+ * @param col left column of the region
+ * @param height number of rows in the region
+ * @param width number of columns in the region
+ * @param bg background color, or -1 to keep the existing background
+ * @param fg foreground color, or -1 to keep the existing foreground
+ */
+void vga_recolor_rect(int row, int col, int height, int width, int bg, int fg) {
+    unsigned short mask = 0;
+    unsigned short bits = 0;
+
+    if (bg >= 0) {
+        mask |= VGA_ATTR_BG_MASK;
+        bits |= VGA_ATTR_BG(bg);
+    }
+    if (fg >= 0) {
+        mask |= VGA_ATTR_FG_MASK;
+        bits |= VGA_ATTR_FG(fg);
+    }
+    if (mask == 0 || !vga_clip_rect(&row, &col, &height, &width)) {
+        return;
+    }
+
+    unsigned int flags = interrupts_save();
+    unsigned short *vga_buf = vga_cells();
+
+    if (width == VGA_WIDTH) {
+        vga_recolor_cells(&vga_buf[row * VGA_WIDTH], mask, bits, height * VGA_WIDTH);
+    } else {
+        for (int r = row; r < row + height; r++) {
+            vga_recolor_cells(&vga_buf[r * VGA_WIDTH + col], mask, bits, width);
+        }
     }
 
+    for (int r = row; r < row + height; r++) {
+        vga_mark_dirty(r, col, col + width);
+    }
+    interrupts_restore(flags);
 }
 
 /**
- * Scrolls the VGA text buffer up by one line
+ * Sets the scroll region of the output console
+ *
+ * Output scrolls only the rows from top to bottom; the rows outside of the
+ * region stay pinned in place. The cursor is moved into the region if it
+ * is outside of it.
+ *
+ * @param top first row of the region (0 to VGA_HEIGHT-1)
+ * @param bottom last row of the region (top to VGA_HEIGHT-1)
+ */
+void vga_scroll_region(int top, int bottom) {
+    if (top < 0 || bottom >= VGA_HEIGHT || top > bottom) {
+        return;
+    }
+
+    unsigned int flags = interrupts_save();
+
+    con->scroll_top = top;
+    con->scroll_bottom = bottom;
+
+    if (con->row < top || con->row > bottom) {
+        con->row = (con->row < top) ? top : bottom;
+        con->col = 0;
+        vga_cursor_update();
+    }
+    interrupts_restore(flags);
+}
+
+/**
+ * Scrolls the scroll region up by one line
+ *
+ * When the region is the whole screen, the ring (if enabled) moves the
+ * window instead of copying. Otherwise only the rows of the region are
+ * moved and marked as changed.
  */
 void vga_scroll(void) {
-    unsigned short *vga_buf = VGA_BASE;
-    for (int i = 0; i < VGA_HEIGHT - 1; i++) {
-        for (int j = 0; j < VGA_WIDTH; j++) {
-            vga_buf[i * VGA_WIDTH + j] = vga_buf[(i + 1) * VGA_WIDTH + j];
+    unsigned int flags = interrupts_save();
+    unsigned short *vga_buf = vga_cells();
+    int top = con->scroll_top;
+    int bottom = con->scroll_bottom;
+    bool full = (top == 0 && bottom == VGA_HEIGHT - 1);
+
+    TRACE(TRACE_VGA_SCROLL, con->origin, top, bottom, 0);
+    COUNTER_INC(COUNTER_VGA_SCROLLS);
+
+    // Save the line scrolling off the top of the screen in the scrollback ring
+    if (top == 0) {
+        memcpy(con->scrollback[con->scrollback_head], vga_buf, sizeof(con->scrollback[0]));
+        con->scrollback_head = (con->scrollback_head + 1) % VGA_SCROLLBACK_LINES;
+        if (con->scrollback_count < VGA_SCROLLBACK_LINES) {
+            con->scrollback_count++;
         }
     }
-    for (int j = 0; j < VGA_WIDTH; j++) {
-        vga_buf[(VGA_HEIGHT - 1) * VGA_WIDTH + j] = VGA_CHAR(bg_color, fg_color, ' ');
+
+    if (full && ring_enabled && !vga_buffered()) {
+        // Move the window instead of the lines; only the newly exposed
+        // line needs to be cleared below
+        vga_ring_advance(1);
+        vga_buf = vga_cells();
+    } else {
+        memmove(&vga_buf[top * VGA_WIDTH], &vga_buf[(top + 1) * VGA_WIDTH],
+                (bottom - top) * VGA_WIDTH * sizeof(unsigned short));
+
+        if (full && ring_enabled) {
+            // Video memory will be scrolled by moving the window at the next
+            // flush, so pending changes move up along with their lines
+            for (int i = 0; i < VGA_HEIGHT - 1; i++) {
+                con->dirty_start[i] = con->dirty_start[i + 1];
+                con->dirty_end[i] = con->dirty_end[i + 1];
+            }
+            con->dirty_start[VGA_HEIGHT - 1] = VGA_WIDTH;
+            con->dirty_end[VGA_HEIGHT - 1] = 0;
+            con->pending++;
+        } else {
+            vga_mark_dirty_cells(top * VGA_WIDTH, bottom * VGA_WIDTH);
+        }
     }
-    current_row--;
-    if (current_row < 0) {
-        current_row = 0;
+
+    vga_fill_cells(&vga_buf[bottom * VGA_WIDTH], VGA_CHAR(con->bg, con->fg, ' '), VGA_WIDTH);
+    vga_mark_dirty(bottom, 0, VGA_WIDTH);
+    con->row--;
+    if (con->row < top) {
+        con->row = top;
     }
     vga_cursor_update();
+    interrupts_restore(flags);
+}
+
+/**
+ * Enables the back buffer (shadow) mode
+ *
+ * The current screen contents are copied into RAM once; afterwards all
+ * vga_* output is written to the shadow buffer and only reaches video
+ * memory when vga_flush() is called.
+ *
+ * @param autoflush if true, vga_puts (and vga_printf) will flush when done
+ */
+void vga_shadow_enable(bool autoflush) {
+    unsigned int flags = interrupts_save();
+
+    if (!shadow_enabled) {
+        // Consoles in the background are already written in RAM
+        memcpy(active->cells, &VGA_BASE[active->origin], sizeof(active->cells));
+
+        for (int row = 0; row < VGA_HEIGHT; row++) {
+            active->dirty_start[row] = VGA_WIDTH;
+            active->dirty_end[row] = 0;
+        }
+        shadow_enabled = true;
+    }
+    shadow_autoflush = autoflush;
+    interrupts_restore(flags);
+}
+
+/**
+ * Disables the back buffer (shadow) mode
+ *
+ * Any pending changes are flushed before writes go back to video memory.
+ */
+void vga_shadow_disable(void) {
+    unsigned int flags = interrupts_save();
+
+    vga_flush();
+    shadow_enabled = false;
+    shadow_autoflush = false;
+    interrupts_restore(flags);
+}
+
+/**
+ * Indicates if the back buffer (shadow) mode is enabled
+ */
+bool vga_shadow_enabled(void) {
+    return shadow_enabled;
+}
+
+/**
+ * Copies the changed spans of the output console's RAM copy to its page of
+ * video memory, first applying any scrolling still pending for the page
+ */
+static void vga_flush_console(void) {
+    COUNTER_INC(COUNTER_VGA_FLUSHES);
+
+    if (con->pending > 0) {
+        vga_ring_advance(con->pending);
+        con->pending = 0;
+    }
+
+    for (int row = 0; row < VGA_HEIGHT; row++) {
+        int start = con->dirty_start[row];
+        int end = con->dirty_end[row];
+
+        if (start < end) {
+            int offset = row * VGA_WIDTH + start;
+            memcpy(&VGA_BASE[con->origin + offset], &con->cells[offset],
+                   (end - start) * sizeof(unsigned short));
+        }
+        con->dirty_start[row] = VGA_WIDTH;
+        con->dirty_end[row] = 0;
+    }
+}
+
+/**
+ * Copies the changed spans of the shadow buffer to video memory
+ *
+ * Only the console on screen is flushed. Does nothing if the shadow buffer
+ * is not enabled.
+ */
+void vga_flush(void) {
+    unsigned int flags = interrupts_save();
+
+    if (shadow_enabled) {
+        vga_console_t *out = con;
+        con = active;
+        vga_flush_console();
+        con = out;
+    }
+    interrupts_restore(flags);
+}
+
+/**
+ * Enables scrolling by moving the CRTC start address through video memory
+ */
+void vga_ring_enable(void) {
+    ring_enabled = true;
+}
+
+/**
+ * Disables ring scrolling
+ *
+ * The visible lines of every console are moved back to the start of its
+ * page and the CRTC start address is reset so the screen looks unchanged.
+ */
+void vga_ring_disable(void) {
+    unsigned int flags = interrupts_save();
+    vga_console_t *out = con;
+
+    for (int i = 0; i < VGA_CONSOLES; i++) {
+        con = &consoles[i];
+
+        if (vga_buffered()) {
+            con->pending = 0;
+            vga_mark_all_dirty();
+        } else if (con->origin != con->page) {
+            memmove(&VGA_BASE[con->page], &VGA_BASE[con->origin],
+                    VGA_HEIGHT * VGA_WIDTH * sizeof(unsigned short));
+        }
+        con->origin = con->page;
+    }
+
+    ring_enabled = false;
+    con = active;
+    vga_ring_update();
+    vga_flush();
+    con = out;
+    vga_cursor_update();
+    interrupts_restore(flags);
+}
+
+/**
+ * Indicates if ring scrolling is enabled
+ */
+bool vga_ring_enabled(void) {
+    return ring_enabled;
+}
+
+/**
+ * Scrolls the view through the scrollback history
+ *
+ * The rows of the scroll region are repainted one line at a time from the
+ * scrollback ring and the saved live screen; rows pinned outside of the
+ * region are left alone. Any output while scrolled back returns the view
+ * to the live screen.
+ *
+ * History is only kept for a region that starts at the top of the screen,
+ * so a region that does not has nothing to scroll back through.
+ *
+ * @param lines number of lines to scroll back (positive) or forward (negative)
+ */
+void vga_scrollback_view(int lines) {
+    unsigned int flags = interrupts_save();
+    int top = con->scroll_top;
+    int bottom = con->scroll_bottom;
+    int max = (top == 0) ? con->scrollback_count : 0;
+    int offset = con->scrollback_offset + lines;
+
+    if (offset < 0) {
+        offset = 0;
+    } else if (offset > max) {
+        offset = max;
+    }
+    if (offset == con->scrollback_offset) {
+        interrupts_restore(flags);
+        return;
+    }
+
+    unsigned short *vga_buf = vga_screen();
+
+    // Keep the live screen so it can be painted back later
+    if (con->scrollback_offset == 0) {
+        memcpy(con->scrollback_live, vga_buf, sizeof(con->scrollback_live));
+    }
+    con->scrollback_offset = offset;
+
+    for (int row = top; row <= bottom; row++) {
+        int line = row - offset;
+        unsigned short *src;
+
+        if (line >= top) {
+            src = &con->scrollback_live[line * VGA_WIDTH];
+        } else {
+            src = con->scrollback[(con->scrollback_head + line - top + VGA_SCROLLBACK_LINES) % VGA_SCROLLBACK_LINES];
+        }
+        memcpy(&vga_buf[row * VGA_WIDTH], src, VGA_WIDTH * sizeof(unsigned short));
+    }
+    vga_mark_dirty_cells(top * VGA_WIDTH, (bottom + 1) * VGA_WIDTH);
+    vga_flush();
+    interrupts_restore(flags);
+}
+
+/**
+ * Returns the number of lines the view is scrolled back (0 when live)
+ */
+int vga_scrollback_offset(void) {
+    return con->scrollback_offset;
+}
+
+/**
+ * Shows a virtual console and makes it the output console
+ *
+ * The console leaving the screen continues in its RAM copy. The console
+ * being shown only has the cells that changed while it was hidden copied
+ * to its page of video memory before the CRTC start address is pointed at
+ * the page.
+ *
+ * @param n console number (0 to VGA_CONSOLES-1)
+ */
+void vga_console_switch(int n) {
+    unsigned int flags;
+
+    if (n < 0 || n >= VGA_CONSOLES) {
+        return;
+    }
+
+    flags = interrupts_save();
+    if (&consoles[n] != active) {
+        // Without the shadow, video memory holds the only up-to-date copy
+        if (!shadow_enabled) {
+            memcpy(active->cells, &VGA_BASE[active->origin], sizeof(active->cells));
+        }
+
+        // Bring the page up to date while the console is still hidden
+        con = &consoles[n];
+        vga_flush_console();
+
+        active = con;
+        vga_ring_update();
+        cursor_hw_pos = -1;
+        vga_cursor_sync();
+    }
+    interrupts_restore(flags);
+}
+
+/**
+ * Directs output to a virtual console without changing what is shown
+ *
+ * @param n console number (0 to VGA_CONSOLES-1)
+ * @return the console number output was directed to before
+ */
+int vga_console_select(int n) {
+    unsigned int flags = interrupts_save();
+    int prev = con - consoles;
+
+    if (n >= 0 && n < VGA_CONSOLES) {
+        con = &consoles[n];
+    }
+    interrupts_restore(flags);
+    return prev;
+}
+
+/**
+ * Returns the number of the virtual console receiving output
+ */
+int vga_console_output(void) {
+    return con - consoles;
+}
+
+/**
+ * Returns the number of the virtual console on screen
+ */
+int vga_console_active(void) {
+    return active - consoles;
+}
+
+/**
+ * Prints the CRTC registers and the driver state to the host and the
+ * serial port
+ *
+ * Used by kernel_panic() to show what the display hardware was last
+ * programmed with. Only reads registers; uses no memory besides the stack.
+ */
+void vga_dump_registers(void) {
+    unsigned char reg;
+
+    kernel_host_printf("vga: crtc");
+    for (reg = 0; reg <= 0x18; reg++) {
+        if ((reg & 7) == 0) {
+            kernel_host_printf("\n  %02x:", reg);
+        }
+        kernel_host_printf(" %02x", vga_crtc_read(reg));
+    }
+    kernel_host_printf("\n");
+
+    kernel_host_printf("vga: console %d shown, %d output, page %d, origin %d, pending %d\n",
+                       (int)(active - consoles), (int)(con - consoles), con->page, con->origin, con->pending);
+    kernel_host_printf("vga: row %d col %d, region %d-%d, cursor %d (%s%s), shadow %d, ring %d\n",
+                       con->row, con->col, con->scroll_top, con->scroll_bottom, cursor_hw_pos,
+                       cursor_enabled ? "on" : "off", cursor_deferred ? ", deferred" : "",
+                       shadow_enabled, ring_enabled);
 }
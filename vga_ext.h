@@ -0,0 +1,54 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * VGA Driver Extensions
+ *
+ * Functions the VGA driver provides in addition to those in vga.h: the
+ * streaming printf, the shadow buffer, ring scrolling, scroll regions,
+ * rectangle fills, scrollback and virtual consoles.
+ */
+#ifndef VGA_EXT_H
+#define VGA_EXT_H
+
+#include <spede/stdarg.h>
+#include <stdbool.h>
+
+#include "vga.h"
+
+// vga.h formats vga_printf with snprintf; the driver now streams it
+#ifdef vga_printf
+#undef vga_printf
+#endif
+
+void vga_printf(const char *fmt, ...);
+void vga_vprintf(const char *fmt, va_list args);
+void vga_write(const char *buf, int len);
+
+void vga_cursor_sync(void);
+void vga_cursor_defer(bool defer);
+
+void vga_fill_rect(int row, int col, int height, int width, int bg, int fg, unsigned char c);
+void vga_recolor_rect(int row, int col, int height, int width, int bg, int fg);
+void vga_scroll_region(int top, int bottom);
+
+void vga_shadow_enable(bool autoflush);
+void vga_shadow_disable(void);
+bool vga_shadow_enabled(void);
+void vga_flush(void);
+
+void vga_ring_enable(void);
+void vga_ring_disable(void);
+bool vga_ring_enabled(void);
+
+void vga_scrollback_view(int lines);
+int vga_scrollback_offset(void);
+
+void vga_console_switch(int n);
+int vga_console_select(int n);
+int vga_console_output(void);
+int vga_console_active(void);
+
+void vga_dump_registers(void);
+
+#endif
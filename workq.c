@@ -0,0 +1,164 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Deferred Work Queue
+ *
+ * Interrupt handlers queue small work items to be run later by the worker
+ * task, with interrupts enabled. Producers reserve and fill a slot with
+ * interrupts disabled; the worker is the only consumer, so it takes items
+ * without any locking.
+ */
+#include "counters.h"
+#include "interrupts.h"
+#include "kernel.h"
+#include "kernel_log.h"
+#include "sched.h"
+#include "trace.h"
+#include "workq.h"
+
+/**
+ * Global variables in this file scope
+ */
+static work_item_t workq_items[WORKQ_SIZE];
+static volatile unsigned int workq_head = 0;    // next slot to fill
+static volatile unsigned int workq_tail = 0;    // next item to run
+static wait_queue_t workq_waiters;              // the worker, when idle
+static workq_stats_t workq_stat;
+
+/**
+ * Worker task: sleeps until work is queued, then runs it in batches
+ */
+static void workq_task(void *arg) {
+    while (1) {
+        unsigned int flags = interrupts_save();
+        while (workq_tail == workq_head) {
+            sched_wait(&workq_waiters);
+        }
+        interrupts_restore(flags);
+
+        if (workq_run(WORKQ_BATCH) == WORKQ_BATCH) {
+            // More may be waiting; give the other tasks a turn first
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * Starts the worker task
+ *
+ * Items queued before this are run once the worker starts.
+ */
+void workq_init(void) {
+    kernel_log_info("Initializing work queue");
+
+    if (!sched_spawn("workq", workq_task, 0)) {
+        kernel_panic("workq: unable to start the worker task");
+    }
+}
+
+/**
+ * Queues a function to be run later by the worker task
+ *
+ * May be called from interrupt handlers.
+ *
+ * @param fn - function to run
+ * @param arg - argument to pass to the function
+ * @return true if queued, false if the queue was full and the item dropped
+ */
+bool workq_queue(work_fn_t fn, unsigned int arg) {
+    unsigned int flags = interrupts_save();
+    unsigned int head = workq_head;
+    unsigned int depth = head - workq_tail;
+
+    if (depth >= WORKQ_SIZE) {
+        workq_stat.dropped++;
+        COUNTER_INC(COUNTER_WORKQ_DROPS);
+        interrupts_restore(flags);
+        return false;
+    }
+
+    work_item_t *item = &workq_items[head & (WORKQ_SIZE - 1)];
+    item->fn = fn;
+    item->arg = arg;
+    item->queued_tsc = trace_rdtsc();
+    workq_head = head + 1;
+
+    workq_stat.queued++;
+    if (depth + 1 > workq_stat.max_depth) {
+        workq_stat.max_depth = depth + 1;
+    }
+    COUNTER_INC(COUNTER_WORKQ_QUEUED);
+
+    sched_wakeup(&workq_waiters);
+    interrupts_restore(flags);
+    return true;
+}
+
+/**
+ * Runs queued work items
+ *
+ * Only the worker task (or code that knows the worker is not running)
+ * may call this.
+ *
+ * @param max - most items to run, or 0 for all of them
+ * @return number of items run
+ */
+int workq_run(int max) {
+    int count = 0;
+
+    while ((max <= 0 || count < max) && workq_tail != workq_head) {
+        work_item_t item = workq_items[workq_tail & (WORKQ_SIZE - 1)];
+        __asm__ __volatile__("" ::: "memory");
+        workq_tail++;
+
+        unsigned long long latency = trace_rdtsc() - item.queued_tsc;
+        unsigned int cycles = (latency > 0xFFFFFFFFULL) ? 0xFFFFFFFF : (unsigned int)latency;
+
+        // total_latency takes two stores on i386; keep workq_stats() from
+        // copying it half updated
+        unsigned int flags = interrupts_save();
+        workq_stat.run++;
+        workq_stat.total_latency += latency;
+        if (cycles > workq_stat.max_latency) {
+            workq_stat.max_latency = cycles;
+        }
+        interrupts_restore(flags);
+        TRACE(TRACE_WORKQ_RUN, (unsigned long)item.fn, item.arg, cycles, 0);
+
+        item.fn(item.arg);
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Copies the deferral statistics
+ *
+ * The copy is made with interrupts disabled: total_latency is 64 bits and
+ * is not read atomically on i386 any other way, so callers read it from
+ * the copy only.
+ *
+ * @param stats - where to copy the statistics to
+ */
+void workq_stats(workq_stats_t *stats) {
+    unsigned int flags = interrupts_save();
+    *stats = workq_stat;
+    interrupts_restore(flags);
+}
+
+/**
+ * Prints the deferral statistics to the host
+ */
+void workq_dump(void) {
+    workq_stats_t stats;
+    unsigned int avg;
+
+    // Only from the copy; see workq_stats()
+    workq_stats(&stats);
+    avg = stats.run ? (unsigned int)(stats.total_latency / stats.run) : 0;
+
+    kernel_host_printf("workq: %u queued, %u run, %u dropped, max depth %u\n",
+                       stats.queued, stats.run, stats.dropped, stats.max_depth);
+    kernel_host_printf("workq: latency avg %u cycles, max %u cycles\n", avg, stats.max_latency);
+}
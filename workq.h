@@ -0,0 +1,51 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ *
+ * Deferred Work Queue
+ */
+#ifndef WORKQ_H
+#define WORKQ_H
+
+#include <stdbool.h>
+
+// Number of items the queue can hold (must be a power of two)
+#ifndef WORKQ_SIZE
+#define WORKQ_SIZE 64
+#endif
+
+// Most items run by the worker before it lets other tasks run
+#ifndef WORKQ_BATCH
+#define WORKQ_BATCH 8
+#endif
+
+typedef void (*work_fn_t)(unsigned int arg);
+
+/**
+ * A unit of deferred work
+ */
+typedef struct work_item {
+    work_fn_t fn;
+    unsigned int arg;
+    unsigned long long queued_tsc;  // time stamp counter when queued
+} work_item_t;
+
+/**
+ * Deferral statistics, in time stamp counter cycles
+ */
+typedef struct workq_stats {
+    unsigned int queued;            // items queued
+    unsigned int run;               // items run
+    unsigned int dropped;           // items dropped because the queue was full
+    unsigned int max_depth;         // most items waiting at once
+    unsigned int max_latency;       // longest time from queued to run
+    unsigned long long total_latency;
+} workq_stats_t;
+
+void workq_init(void);
+bool workq_queue(work_fn_t fn, unsigned int arg);
+int workq_run(int max);
+void workq_stats(workq_stats_t *stats);
+void workq_dump(void);
+
+#endif